@@ -55,7 +55,64 @@
  *   - game_music.wav
  *
  * COMPILE:
- *   g++ -o SpaceShooter SpaceShooter_Enhanced.cpp -lsfml-graphics -lsfml-window -lsfml-system -lsfml-audio
+ *   g++ -o SpaceShooter SpaceShooter_Enhanced.cpp -lsfml-graphics -lsfml-window -lsfml-system -lsfml-audio -pthread
+ *
+ * BENCHMARKS:
+ *   SpaceShooter --bench [all|collisions|particles|startup|random|micro]
+ *   SpaceShooter --bench micro [vector2|collision|particles|random|compaction|boss]
+ *                [--items N]
+ *   Microbenchmarks report ns per item and items/s for each kernel at 256,
+ *   4096 and 65536 items (or N). Compile with -DSPACE_SHOOTER_NO_MAIN to link
+ *   the kernels into a test binary without this file's main().
+ *
+ * SCENARIOS:
+ *   SpaceShooter --scenarios [name] [--ticks N] [--runs N] [--json file]
+ *                [--compare baseline.json] [--threshold percent]
+ *   Times update, collision, removeInactive, particles and draw-list build per
+ *   tick (mean/p50/p99) in fixed heavy scenes: dragon-wave, boss-phase-3,
+ *   nuke-30, particles-5000. Each figure is the median of --runs runs
+ *   (default 5). --compare exits non-zero when a metric is over the threshold
+ *   in every run.
+ *
+ * HEADLESS:
+ *   SpaceShooter --headless [ticks] [--seed N] [--script file] [--record file]
+ *                [--profile [file]] [--alloc-check [warm-up ticks]]
+ *                [--alloc-allow spawn|new-game]...
+ *   SpaceShooter --headless --replay file
+ *   Runs the gameplay simulation flat out with no window, textures or audio
+ *   device (random input unless a script is given) and reports ticks/s,
+ *   entity counts and peak memory. A replay runs until the recording ends.
+ *   --alloc-check exits non-zero if any tick allocates after the warm-up
+ *   (default 600 ticks) and lists the profiling zones that allocated. Every
+ *   allocation counts unless --alloc-allow excuses its reason: spawn (an
+ *   enemy or boss past its arena's blocks) or new-game (starting a game over).
+ *   Needs a debug build or -DSPACE_SHOOTER_TRACK_ALLOCATIONS.
+ *
+ * ASSET BUNDLE:
+ *   SpaceShooter --pack-assets [assets/assets.bundle]
+ *   Pre-decodes every asset into one file that is memory-mapped at startup.
+ *   Loose files are used whenever the bundle is missing or out of date, and
+ *   for any single asset whose source file is newer than its bundle entry.
+ *
+ * OPTIONS:
+ *   --sync-music             Open music on the game thread (old behaviour), to
+ *                            compare the [PERF] screen-transition frame times
+ *   --tick-rate <hz>         Fixed simulation rate (default 120); rendering
+ *                            interpolates between ticks
+ *   --single-thread          Simulate and render on one thread, to compare
+ *                            the [PERF] ticks/s and frames/s printed on exit
+ *   F3 (debug builds)        Performance overlay: frame-time graph, CPU time
+ *                            per subsystem, entity and draw-call counts
+ *   --record <file>          Record every game's seed and per-tick input
+ *   --replay <file>          Play a recording back instead of the keyboard;
+ *                            state checksums in it show whether it matched
+ *   --profile [file]         Record profiling zones from startup and write
+ *                            them at exit as a Chrome trace (trace.json);
+ *                            open it in chrome://tracing or ui.perfetto.dev
+ *   F4                       Start profiling; press again to write the trace
+ *   --track-allocations      Count heap allocations per frame and per
+ *                            profiling zone, reported on exit (debug builds,
+ *                            or release with -DSPACE_SHOOTER_TRACK_ALLOCATIONS)
  *
  * ============================================================================
  */
@@ -71,9 +128,51 @@
 #include <cmath>
 #include <string>
 #include <map>
+#include <array>
 #include <deque>
 #include <chrono>
 #include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#include <sys/types.h>
+#include <sys/stat.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define PARTICLES_USE_SSE
+#endif
+
+// The F3 performance overlay only exists in debug builds
+#ifndef NDEBUG
+#define PERF_OVERLAY
+#endif
+
+// Global operator new/delete are replaced to feed the AllocationTracker in
+// debug builds, or in release with -DSPACE_SHOOTER_TRACK_ALLOCATIONS. A
+// program that links this file in without main() keeps its own.
+#if (!defined(NDEBUG) || defined(SPACE_SHOOTER_TRACK_ALLOCATIONS)) && !defined(SPACE_SHOOTER_NO_MAIN)
+#define ALLOCATION_TRACKER
+#endif
 
 using namespace std;
 
@@ -87,6 +186,8 @@ const string GAME_TITLE = "Space Shooter Ultimate Edition v5.0";
 const int MAX_HIGH_SCORES = 10;
 const float PI = 3.14159265359f;
 const int TARGET_FPS = 60;
+const float SIMULATION_TICK_RATE = 120.0f;   // fixed simulation steps per second
+const int MAX_SIMULATION_STEPS = 8;          // catch-up cap per rendered frame
 
 // Game Balance Settings
 const int MAX_LEVELS = 2;
@@ -96,736 +197,3279 @@ const float PLAYER_MAX_SHIELD = 50.0f;
 const float BASE_FIRE_RATE = 0.25f;
 const float MIN_FIRE_RATE = 0.10f;
 const float MAX_PLAYER_SPEED = 350.0f;
+const size_t MAX_BULLETS = 2048;
+const size_t ENEMY_RESERVE = 256;            // collision buffers are sized for this many enemies up front
+const size_t MAX_POWERUPS = 64;
+const size_t MAX_EXPLOSIONS = 256;
+const size_t ENEMY_BLOCK_SIZE = 512;         // bytes per pooled enemy object; the largest enemy must fit
+const size_t BOSS_BLOCK_SIZE = 1024;
+const int MAX_PARTICLES = 500;               // per ParticleSystem; raise up to the limit below
+const int MAX_THRUST_PARTICLES = 500;
+const int PARTICLE_CAPACITY_LIMIT = 100000;
+const float PARTICLE_DRAG = 0.98f;           // velocity kept per 1/TARGET_FPS seconds
+const float MIN_PARTICLE_LIFETIME = 0.01f;   // seconds; keeps the fade reciprocal finite
+const int SOUND_VOICE_COUNT = 32;            // concurrent sound effects across all sounds
+const float SOUND_COALESCE_GAIN_STEP = 0.15f; // extra gain per repeated trigger within a frame
+const float SOUND_COALESCE_MAX_GAIN = 1.6f;
+const float MUSIC_CROSSFADE_TIME = 1.0f;     // seconds
 
 // ============================================================================
-// TEXTURE MANAGER - Loads and manages all game textures
+// PROFILER - Scoped zones dumped as Chrome trace events
 // ============================================================================
-
-class TextureManager {
+//
+// ProfileZone times the scope it is declared in. Each thread writes its zones
+// into its own ring buffer (no locks; the oldest zones are overwritten once it
+// wraps), and writeTrace() dumps every ring as trace-event JSON that
+// chrome://tracing and ui.perfetto.dev open. Turned on with --profile (written
+// at exit) or F4 (press again to write); while off a zone is one branch.
+// Zones also name the scope that the AllocationTracker charges allocations to.
+
+const size_t PROFILE_RING_SIZE = 1 << 16;   // zones kept per thread
+const char* const PROFILE_DEFAULT_PATH = "trace.json";
+
+class Profiler {
 private:
-    map<string, sf::Texture> textures;
-    static TextureManager* instance;
+    // Written only by the owning thread. Fields are atomics so the dump can
+    // read a ring while its thread keeps going.
+    struct Zone {
+        atomic<const char*> name{ nullptr };
+        atomic<int64_t> start{ 0 };      // steady_clock nanoseconds
+        atomic<int64_t> duration{ 0 };
+    };
 
-public:
-    static TextureManager& getInstance() {
-        if (!instance) {
-            instance = new TextureManager();
-        }
-        return *instance;
-    }
+    struct Ring {
+        array<Zone, PROFILE_RING_SIZE> zones;
+        atomic<uint64_t> head{ 0 };      // zones ever written
+        const char* threadName = "thread";
+        int threadId = 0;
+        bool inUse = true;               // guarded by registryMutex()
+    };
 
-    bool loadTexture(const string& name, const string& filepath) {
-        sf::Texture texture;
-        if (texture.loadFromFile(filepath)) {
-            texture.setSmooth(true);
-            textures[name] = texture;
-            cout << "[OK] Loaded: " << filepath << endl;
-            return true;
+    // Hands the thread's ring back when the thread exits
+    struct RingLease {
+        Ring* ring = nullptr;
+        ~RingLease() {
+            if (!ring) return;
+            lock_guard<mutex> lock(registryMutex());
+            ring->inUse = false;
         }
-        cerr << "[FAIL] Could not load: " << filepath << endl;
-        return false;
-    }
+    };
 
-    sf::Texture& getTexture(const string& name) {
-        return textures[name];
+    // Which users want zones: bit 0 tracing, bit 1 allocation tracking
+    static atomic<unsigned>& modeFlags() {
+        static atomic<unsigned> flags{ 0 };
+        return flags;
     }
 
-    bool hasTexture(const string& name) {
-        return textures.find(name) != textures.end();
+    static atomic<int64_t>& startedAt() {
+        static atomic<int64_t> at{ 0 };
+        return at;
     }
 
-    void loadAllTextures() {
-        cout << "\n=== Loading Game Assets ===" << endl;
-
-        // Player
-        loadTexture("spaceship", "assets/spaceship.png");
-        loadTexture("player_bullet", "assets/player_bullet.png");
-        loadTexture("shield_effect", "assets/shield_effect.png");
-
-        // Enemies
-        loadTexture("enemy_alpha", "assets/enemy_alpha.png");
-        loadTexture("enemy_beta", "assets/enemy_beta.png");
-        loadTexture("enemy_gamma", "assets/enemy_gamma.png");
-        loadTexture("enemy_monster", "assets/enemy_monster.png");
-        loadTexture("enemy_phantom", "assets/enemy_phantom.png");
-        loadTexture("enemy_dragon", "assets/enemy_dragon.gif");
-        loadTexture("enemy_bullet", "assets/enemy_bullet.png");
-
-        // Boss
-        loadTexture("boss", "assets/boss.png");
-        loadTexture("boss_eye", "assets/boss_eye.png");
-        loadTexture("boss_bullet", "assets/boss_bullet.png");
-
-        // Power-ups
-        loadTexture("powerup_power", "assets/powerup_power.png");
-        loadTexture("powerup_fire", "assets/powerup_fire.png");
-        loadTexture("powerup_shield", "assets/powerup_shield.png");
-        loadTexture("powerup_lives", "assets/powerup_lives.png");
-        loadTexture("powerup_nuke", "assets/powerup_nuke.png");
-        loadTexture("powerup_multishot", "assets/powerup_multishot.png");
-        loadTexture("powerup_slow", "assets/powerup_slow.png");
-        loadTexture("powerup_danger", "assets/powerup_danger.png");
-
-        // Effects
-        loadTexture("explosion", "assets/explosion.png");
-
-        // Backgrounds
-        loadTexture("background", "assets/background.png");
-        loadTexture("menu_background", "assets/menu_background.png");
-        loadTexture("boss_background", "assets/boss_background.png");
-
-        // UI
-        loadTexture("logo", "assets/logo.png");
-        loadTexture("intro_video", "assets/intro_video.png");
-
-        cout << "=== Asset Loading Complete ===\n" << endl;
+    // Rings outlive their threads, so zones from finished workers still dump.
+    // A new thread takes over the ring of a finished one with the same name
+    // (short-lived music loaders, say), which keeps the registry from growing
+    // with every thread ever started; they then share one track in the trace.
+    static mutex& registryMutex() {
+        static mutex m;
+        return m;
     }
-};
-
-TextureManager* TextureManager::instance = nullptr;
 
-// ============================================================================
-// SOUND MANAGER - Loads and manages all game sounds
-// ============================================================================
+    static vector<unique_ptr<Ring>>& rings() {
+        static vector<unique_ptr<Ring>> all;
+        return all;
+    }
 
-class SoundManager {
-private:
-    map<string, sf::SoundBuffer> buffers;
-    map<string, sf::Sound> sounds;
-    sf::Music backgroundMusic;
-    bool soundEnabled;
-    float masterVolume;
-    static SoundManager* instance;
+    static const char*& currentThreadName() {
+        thread_local const char* name = "thread";
+        return name;
+    }
 
-public:
-    static SoundManager& getInstance() {
-        if (!instance) {
-            instance = new SoundManager();
+    static Ring& threadRing() {
+        thread_local RingLease lease;
+        if (!lease.ring) {
+            lock_guard<mutex> lock(registryMutex());
+            const char* name = currentThreadName();
+            for (const auto& ring : rings()) {
+                if (!ring->inUse && strcmp(ring->threadName, name) == 0) {
+                    lease.ring = ring.get();
+                    break;
+                }
+            }
+            if (!lease.ring) {
+                rings().push_back(make_unique<Ring>());
+                lease.ring = rings().back().get();
+                lease.ring->threadName = name;
+                lease.ring->threadId = static_cast<int>(rings().size());
+            }
+            lease.ring->inUse = true;
         }
-        return *instance;
+        return *lease.ring;
     }
 
-    SoundManager() : soundEnabled(true), masterVolume(70.0f) {}
+public:
+    static const unsigned TRACE = 1;
+    static const unsigned ALLOCATIONS = 2;
+
+    static bool isEnabled() { return (modeFlags().load(memory_order_relaxed) & TRACE) != 0; }
+    static bool isActive() { return modeFlags().load(memory_order_relaxed) != 0; }
+    static void setMode(unsigned mode, bool on) {
+        if (on) modeFlags().fetch_or(mode, memory_order_relaxed);
+        else modeFlags().fetch_and(~mode, memory_order_relaxed);
+    }
 
-    bool loadSound(const string& name, const string& filepath) {
-        sf::SoundBuffer buffer;
-        if (buffer.loadFromFile(filepath)) {
-            buffers[name] = buffer;
-            sounds[name].setBuffer(buffers[name]);
-            sounds[name].setVolume(masterVolume);
-            cout << "[OK] Loaded sound: " << filepath << endl;
-            return true;
-        }
-        cerr << "[FAIL] Could not load sound: " << filepath << endl;
-        return false;
+    // Innermost zone open on this thread, while zones are active
+    static const char*& currentZone() {
+        thread_local const char* zone = nullptr;
+        return zone;
     }
 
-    void loadAllSounds() {
-        cout << "\n=== Loading Sound Assets ===" << endl;
-        loadSound("shoot", "assets/shoot.wav");
-        loadSound("explosion", "assets/explosion.wav");
-        loadSound("powerup", "assets/powerup.wav");
-        loadSound("hit", "assets/hit.wav");
-        loadSound("boss_hit", "assets/boss_hit.wav");
-        loadSound("player_hurt", "assets/player_hurt.wav");
-        loadSound("level_up", "assets/level_up.wav");
-        loadSound("game_over", "assets/game_over.wav");
-        loadSound("victory", "assets/victory.wav");
-        cout << "=== Sound Loading Complete ===\n" << endl;
+    static int64_t now() {
+        return chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now().time_since_epoch()).count();
     }
 
-    void playSound(const string& name) {
-        if (soundEnabled && sounds.find(name) != sounds.end()) {
-            sounds[name].play();
-        }
+    // Zones from before this call are left out of the next trace
+    static void start() {
+        startedAt().store(now(), memory_order_relaxed);
+        setMode(TRACE, true);
     }
 
-    void playMusic(const string& filepath, bool loop = true) {
-        if (backgroundMusic.openFromFile(filepath)) {
-            backgroundMusic.setLoop(loop);
-            backgroundMusic.setVolume(masterVolume * 0.5f);
-            if (soundEnabled) {
-                backgroundMusic.play();
-            }
-        }
+    static void stop() { setMode(TRACE, false); }
+
+    // Call at the top of a thread, before its first zone; name must be a literal
+    static void setThreadName(const char* name) {
+        currentThreadName() = name;
     }
 
-    void stopMusic() {
-        backgroundMusic.stop();
+    static void record(const char* name, int64_t start, int64_t end) {
+        Ring& ring = threadRing();
+        uint64_t index = ring.head.load(memory_order_relaxed);
+        Zone& zone = ring.zones[index % PROFILE_RING_SIZE];
+        // Orders the previous head store before these, so a dump that read a
+        // half-written slot sees the head that marks it as overwritten
+        atomic_thread_fence(memory_order_release);
+        zone.name.store(name, memory_order_relaxed);
+        zone.start.store(start, memory_order_relaxed);
+        zone.duration.store(end - start, memory_order_relaxed);
+        ring.head.store(index + 1, memory_order_release);
     }
 
-    void toggleSound() {
-        soundEnabled = !soundEnabled;
-        if (!soundEnabled) {
-            backgroundMusic.pause();
+    // Zones copied out of the rings; written to a file later, holding no locks
+    struct Capture {
+        struct Event {
+            const char* name;
+            int64_t start, duration;
+            int threadId;
+        };
+        vector<Event> events;
+        vector<pair<int, const char*>> threads;
+        int64_t since = 0;
+
+        bool write(const string& path) const {
+            ofstream out(path);
+            if (!out) {
+                cerr << "[FAIL] Could not write trace: " << path << endl;
+                return false;
+            }
+            out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+            for (const auto& thread : threads) {
+                out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.first
+                    << ",\"args\":{\"name\":\"" << thread.second << "\"}},\n";
+            }
+            size_t written = 0;
+            char line[256];
+            for (const Event& event : events) {
+                if (event.start < since) continue;
+                snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    written ? ",\n" : "", event.name, event.threadId,
+                    (event.start - since) / 1000.0, event.duration / 1000.0);
+                out << line;
+                written++;
+            }
+            // Metadata lines end in a comma; an empty trace still needs an element after them
+            if (!written) out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"SpaceShooter\"}}";
+            out << "\n]}\n";
+            if (!out) {
+                cerr << "[FAIL] Could not write trace: " << path << endl;
+                return false;
+            }
+            cout << "[OK] Wrote " << written << " profile zones to " << path << endl;
+            return true;
         }
-        else {
-            backgroundMusic.play();
+    };
+
+    // Any thread, while the others keep recording
+    static Capture capture() {
+        Capture captured;
+        vector<Capture::Event>& events = captured.events;
+        captured.since = startedAt().load(memory_order_relaxed);
+        lock_guard<mutex> lock(registryMutex());
+        for (const auto& ring : rings()) {
+            captured.threads.emplace_back(ring->threadId, ring->threadName);
+            uint64_t head = ring->head.load(memory_order_acquire);
+            uint64_t first = head > PROFILE_RING_SIZE ? head - PROFILE_RING_SIZE : 0;
+            size_t copied = events.size();
+            for (uint64_t i = first; i < head; i++) {
+                const Zone& zone = ring->zones[i % PROFILE_RING_SIZE];
+                events.push_back({ zone.name.load(memory_order_relaxed), zone.start.load(memory_order_relaxed),
+                    zone.duration.load(memory_order_relaxed), ring->threadId });
+            }
+            // Drop slots the thread may have reused (or be writing) meanwhile
+            atomic_thread_fence(memory_order_acquire);
+            uint64_t headAfter = ring->head.load(memory_order_relaxed);
+            uint64_t valid = headAfter + 1 > PROFILE_RING_SIZE ? headAfter + 1 - PROFILE_RING_SIZE : 0;
+            if (valid > first) {
+                size_t stale = static_cast<size_t>(min<uint64_t>(valid - first, head - first));
+                events.erase(events.begin() + copied, events.begin() + copied + stale);
+            }
         }
+        return captured;
     }
 
-    bool isSoundEnabled() const { return soundEnabled; }
-    void setVolume(float vol) { masterVolume = vol; }
+    static bool writeTrace(const string& path) { return capture().write(path); }
 };
 
-SoundManager* SoundManager::instance = nullptr;
-
-// ============================================================================
-// RANDOM GENERATOR
-// ============================================================================
-
-class RandomGenerator {
+// Declare as: ProfileZone zone("Name"); the name must be a string literal
+class ProfileZone {
 private:
-    static mt19937 generator;
+    const char* name = nullptr;
+    const char* parent = nullptr;
+    int64_t start = 0;                 // 0 unless tracing when the zone opened
+
+    void begin(const char* zoneName) {
+        name = zoneName;
+        parent = Profiler::currentZone();
+        Profiler::currentZone() = name;
+        if (Profiler::isEnabled()) start = Profiler::now();
+    }
 
-public:
-    static void seed() {
-        generator.seed(static_cast<unsigned>(chrono::system_clock::now().time_since_epoch().count()));
+    void end() {
+        Profiler::currentZone() = parent;
+        if (start) Profiler::record(name, start, Profiler::now());
     }
 
-    static float range(float min, float max) {
-        uniform_real_distribution<float> dist(min, max);
-        return dist(generator);
+public:
+    explicit ProfileZone(const char* zoneName) {
+        if (Profiler::isActive()) begin(zoneName);
     }
 
-    static int range(int min, int max) {
-        uniform_int_distribution<int> dist(min, max);
-        return dist(generator);
+    ~ProfileZone() {
+        if (name) end();
     }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
 };
 
-mt19937 RandomGenerator::generator;
+// Counts every operator new while started, in total and per profiling zone
+// (the innermost ProfileZone open on the allocating thread). Off by default;
+// the replaced operators then only check one flag before calling malloc.
+class AllocationTracker {
+private:
+    struct Site {
+        atomic<const char*> zone{ nullptr };   // or an allowed AllocationReason
+        atomic<uint64_t> count{ 0 };
+        atomic<uint64_t> bytes{ 0 };
+        atomic<bool> allowed{ false };
+    };
 
-// ============================================================================
-// VECTOR2 UTILITY CLASS
-// ============================================================================
+    static const size_t SITE_SLOTS = 128;     // distinct zones; extras share the last slot
+    static const size_t ALLOWED_SLOTS = 8;
 
-class Vector2 {
-public:
-    float x, y;
+    // Constant-initialized, so usable by allocations made before main()
+    static atomic<bool>& activeFlag() {
+        static atomic<bool> active{ false };
+        return active;
+    }
 
-    Vector2() : x(0), y(0) {}
-    Vector2(float x, float y) : x(x), y(y) {}
+    static atomic<uint64_t>& totalCount() {
+        static atomic<uint64_t> count{ 0 };
+        return count;
+    }
 
-    Vector2 operator+(const Vector2& other) const { return Vector2(x + other.x, y + other.y); }
-    Vector2 operator-(const Vector2& other) const { return Vector2(x - other.x, y - other.y); }
-    Vector2 operator*(float scalar) const { return Vector2(x * scalar, y * scalar); }
-    Vector2 operator/(float scalar) const { return scalar != 0 ? Vector2(x / scalar, y / scalar) : *this; }
+    static atomic<uint64_t>& totalBytes() {
+        static atomic<uint64_t> bytes{ 0 };
+        return bytes;
+    }
 
-    float length() const { return sqrt(x * x + y * y); }
-    float distanceTo(const Vector2& other) const { return (*this - other).length(); }
+    static atomic<uint64_t>& allowedCount() {
+        static atomic<uint64_t> count{ 0 };
+        return count;
+    }
 
-    Vector2 normalized() const {
-        float len = length();
-        return len > 0.0001f ? Vector2(x / len, y / len) : Vector2(0, 0);
+    // Reasons passed to allow(); set up before tracking starts
+    static array<const char*, ALLOWED_SLOTS>& allowedReasons() {
+        static array<const char*, ALLOWED_SLOTS> reasons{};
+        return reasons;
     }
 
-    float angle() const { return atan2(y, x) * 180.0f / PI; }
-};
+    static bool isAllowed(const char* reason) {
+        for (const char* allowed : allowedReasons()) {
+            if (allowed && strcmp(allowed, reason) == 0) return true;
+        }
+        return false;
+    }
 
-// ============================================================================
-// PARTICLE SYSTEM
-// ============================================================================
+    static array<Site, SITE_SLOTS>& sites() {
+        static array<Site, SITE_SLOTS> all;
+        return all;
+    }
 
-struct Particle {
-    Vector2 position;
-    Vector2 velocity;
-    sf::Color color;
-    float lifetime;
-    float maxLifetime;
-    float size;
-    float rotation;
-    float rotationSpeed;
+    // Open addressing on the name's address; zone names are string literals
+    static Site& siteFor(const char* zone) {
+        array<Site, SITE_SLOTS>& all = sites();
+        size_t slot = (reinterpret_cast<uintptr_t>(zone) >> 3) % (SITE_SLOTS - 1);
+        for (size_t probe = 0; probe < SITE_SLOTS - 1; probe++) {
+            Site& site = all[(slot + probe) % (SITE_SLOTS - 1)];
+            const char* owner = site.zone.load(memory_order_relaxed);
+            if (owner == zone) return site;
+            if (!owner && site.zone.compare_exchange_strong(owner, zone, memory_order_relaxed)) return site;
+            if (owner == zone) return site;   // another thread claimed it for the same zone
+        }
+        return all[SITE_SLOTS - 1];
+    }
 
-    Particle(const Vector2& pos, const Vector2& vel, const sf::Color& col, float life, float sz)
-        : position(pos), velocity(vel), color(col), lifetime(life), maxLifetime(life), size(sz),
-        rotation(0), rotationSpeed(RandomGenerator::range(-180.0f, 180.0f)) {}
+    static void printSites(bool allowed, size_t limit) {
+        vector<pair<uint64_t, const Site*>> ranked;
+        for (const Site& site : sites()) {
+            uint64_t count = site.count.load(memory_order_relaxed);
+            if (count && site.allowed.load(memory_order_relaxed) == allowed) ranked.emplace_back(count, &site);
+        }
+        sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+        if (ranked.size() > limit) ranked.resize(limit);
+        for (const auto& entry : ranked) {
+            const char* zone = entry.second->zone.load(memory_order_relaxed);
+            cout << "    " << entry.first << " allocations, " << entry.second->bytes.load(memory_order_relaxed)
+                << " bytes " << (allowed ? "allowed for " : "in ") << (zone ? zone : "(other zones)") << endl;
+        }
+    }
 
-    void update(float dt) {
-        position = position + velocity * dt;
-        velocity = velocity * 0.98f;
-        lifetime -= dt;
-        rotation += rotationSpeed * dt;
-        float alpha = (lifetime / maxLifetime) * 255.0f;
-        color.a = static_cast<sf::Uint8>(max(0.0f, alpha));
+public:
+    // Set by AllocationReason on the allocating thread
+    static const char*& currentReason() {
+        thread_local const char* reason = nullptr;
+        return reason;
     }
 
-    bool isAlive() const { return lifetime > 0; }
-};
+    // Stops counting allocations made for this reason against a frame; false
+    // when too many reasons are allowed already
+    static bool allow(const char* reason) {
+        for (const char*& allowed : allowedReasons()) {
+            if (!allowed || strcmp(allowed, reason) == 0) {
+                allowed = reason;
+                return true;
+            }
+        }
+        return false;
+    }
 
-class ParticleSystem {
-private:
-    deque<Particle> particles;
-    int maxParticles;
+    // False when operator new isn't replaced in this build, so nothing is counted
+    static bool isBuiltIn() {
+#ifdef ALLOCATION_TRACKER
+        return true;
+#else
+        return false;
+#endif
+    }
 
-public:
-    ParticleSystem(int max = 500) : maxParticles(max) {}
+    static void start() {
+        activeFlag().store(true, memory_order_relaxed);
+        Profiler::setMode(Profiler::ALLOCATIONS, true);
+    }
 
-    void emit(const Vector2& pos, const Vector2& baseVel, const sf::Color& color, int count, float life, float size = 3.0f) {
-        for (int i = 0; i < count && particles.size() < static_cast<size_t>(maxParticles); i++) {
-            Vector2 vel = baseVel + Vector2(RandomGenerator::range(-80.0f, 80.0f), RandomGenerator::range(-80.0f, 80.0f));
-            particles.emplace_back(pos, vel, color, life + RandomGenerator::range(-0.2f, 0.2f), size);
+    static void stop() {
+        activeFlag().store(false, memory_order_relaxed);
+        Profiler::setMode(Profiler::ALLOCATIONS, false);
+    }
+
+    static bool isActive() { return activeFlag().load(memory_order_relaxed); }
+
+    // From operator new; must not allocate
+    static void noteAllocation(size_t bytes) {
+        if (!activeFlag().load(memory_order_relaxed)) return;
+        const char* reason = currentReason();
+        if (reason && isAllowed(reason)) {
+            allowedCount().fetch_add(1, memory_order_relaxed);
+            Site& site = siteFor(reason);
+            site.allowed.store(true, memory_order_relaxed);
+            site.count.fetch_add(1, memory_order_relaxed);
+            site.bytes.fetch_add(bytes, memory_order_relaxed);
+            return;
         }
+        totalCount().fetch_add(1, memory_order_relaxed);
+        totalBytes().fetch_add(bytes, memory_order_relaxed);
+        const char* zone = Profiler::currentZone();
+        Site& site = siteFor(zone ? zone : "(outside any zone)");
+        site.count.fetch_add(1, memory_order_relaxed);
+        site.bytes.fetch_add(bytes, memory_order_relaxed);
     }
 
-    void emitExplosion(const Vector2& pos, int count, float size) {
-        for (int i = 0; i < count && particles.size() < static_cast<size_t>(maxParticles); i++) {
-            float angle = RandomGenerator::range(0.0f, 360.0f) * PI / 180.0f;
-            float speed = RandomGenerator::range(50.0f, 200.0f);
-            Vector2 vel(cos(angle) * speed, sin(angle) * speed);
-            sf::Color col;
-            int colorType = RandomGenerator::range(0, 3);
-            if (colorType == 0) col = sf::Color(255, 200, 50);
-            else if (colorType == 1) col = sf::Color(255, 100, 0);
-            else col = sf::Color(255, 50, 0);
-            particles.emplace_back(pos, vel, col, RandomGenerator::range(0.5f, 1.2f), size);
+    // Running totals since the program started tracking; allowed allocations
+    // are counted apart and left out of these
+    static uint64_t getCount() { return totalCount().load(memory_order_relaxed); }
+    static uint64_t getBytes() { return totalBytes().load(memory_order_relaxed); }
+    static uint64_t getAllowedCount() { return allowedCount().load(memory_order_relaxed); }
+
+    // Starts the per-zone breakdown over, e.g. once a warm-up is done
+    static void clearZones() {
+        for (Site& site : sites()) {
+            site.count.store(0, memory_order_relaxed);
+            site.bytes.store(0, memory_order_relaxed);
         }
     }
 
-    void update(float dt) {
-        for (auto& p : particles) p.update(dt);
-        while (!particles.empty() && !particles.front().isAlive()) particles.pop_front();
+    // Zones by allocation count, most first, then the allowed allocations
+    static void printZones(size_t limit = 12) {
+        printSites(false, limit);
+        printSites(true, limit);
     }
+};
 
-    void draw(sf::RenderWindow& window) {
-        for (auto& p : particles) {
-            sf::CircleShape shape(p.size);
-            shape.setFillColor(p.color);
-            shape.setOrigin(p.size, p.size);
-            shape.setPosition(p.position.x, p.position.y);
-            shape.setRotation(p.rotation);
-            window.draw(shape);
-        }
+// Names why the allocations in its scope happen, e.g. an enemy that didn't
+// fit its arena. They count like any other unless that reason was passed to
+// AllocationTracker::allow(). Declare as: AllocationReason reason("spawn");
+// the name must be one of ALLOCATION_REASONS.
+const char* const ALLOCATION_REASONS[] = { "spawn", "new-game" };
+
+class AllocationReason {
+private:
+    const char* previous;
+
+public:
+    explicit AllocationReason(const char* reason) : previous(AllocationTracker::currentReason()) {
+        AllocationTracker::currentReason() = reason;
     }
 
-    void clear() { particles.clear(); }
-    size_t getCount() const { return particles.size(); }
-};
+    ~AllocationReason() { AllocationTracker::currentReason() = previous; }
 
-// ============================================================================
-// STARFIELD BACKGROUND
-// ============================================================================
+    AllocationReason(const AllocationReason&) = delete;
+    AllocationReason& operator=(const AllocationReason&) = delete;
+};
 
-class Starfield {
+// Splits the tracker's running totals into frames (or ticks). Frames before
+// warmUp aren't judged, and the zone breakdown starts over when it ends.
+class AllocationFrames {
 private:
-    struct Star {
-        float x, y, speed, brightness, size;
-    };
-    vector<Star> stars;
+    uint64_t warmUp;
+    uint64_t frames = 0;
+    uint64_t lastCount = 0, lastBytes = 0;
+    uint64_t allocatingFrames = 0, firstAllocatingFrame = 0;
+    uint64_t count = 0, bytes = 0, worstCount = 0, worstBytes = 0;
+    uint64_t allowedAtWarmUp = 0;
 
 public:
-    Starfield(int count = 200) {
-        for (int i = 0; i < count; i++) {
-            Star s;
-            s.x = RandomGenerator::range(0.0f, SCREEN_WIDTH);
-            s.y = RandomGenerator::range(0.0f, SCREEN_HEIGHT);
-            s.speed = RandomGenerator::range(20.0f, 100.0f);
-            s.brightness = RandomGenerator::range(100.0f, 255.0f);
-            s.size = RandomGenerator::range(1.0f, 2.5f);
-            stars.push_back(s);
-        }
+    explicit AllocationFrames(uint64_t warmUpFrames = 0) : warmUp(warmUpFrames) {
+        lastCount = AllocationTracker::getCount();
+        lastBytes = AllocationTracker::getBytes();
+        allowedAtWarmUp = AllocationTracker::getAllowedCount();
     }
 
-    void update(float dt) {
-        for (auto& s : stars) {
-            s.y += s.speed * dt;
-            if (s.y > SCREEN_HEIGHT) {
-                s.y = -5;
-                s.x = RandomGenerator::range(0.0f, SCREEN_WIDTH);
+    void endFrame() {
+        uint64_t nowCount = AllocationTracker::getCount();
+        uint64_t nowBytes = AllocationTracker::getBytes();
+        uint64_t frameCount = nowCount - lastCount;
+        uint64_t frameBytes = nowBytes - lastBytes;
+        lastCount = nowCount;
+        lastBytes = nowBytes;
+        if (++frames <= warmUp) {
+            if (frames == warmUp) {
+                AllocationTracker::clearZones();
+                allowedAtWarmUp = AllocationTracker::getAllowedCount();
             }
+            return;
         }
+        if (frameCount == 0) return;
+        if (allocatingFrames++ == 0) firstAllocatingFrame = frames;
+        count += frameCount;
+        bytes += frameBytes;
+        worstCount = max(worstCount, frameCount);
+        worstBytes = max(worstBytes, frameBytes);
     }
 
-    void draw(sf::RenderWindow& window) {
-        for (auto& s : stars) {
-            sf::CircleShape star(s.size);
-            star.setFillColor(sf::Color(255, 255, 255, static_cast<sf::Uint8>(s.brightness)));
-            star.setPosition(s.x, s.y);
-            window.draw(star);
+    bool allocatedAfterWarmUp() const { return allocatingFrames > 0; }
+
+    void printReport(const char* unit) const {
+        uint64_t judged = frames > warmUp ? frames - warmUp : 0;
+        cout << "  allocations after " << warmUp << " warm-up " << unit << "s: " << count << " ("
+            << bytes << " bytes) in " << allocatingFrames << "/" << judged << " " << unit << "s";
+        if (allocatingFrames) {
+            cout << ", first at " << unit << " " << firstAllocatingFrame << ", worst " << worstCount
+                << " (" << worstBytes << " bytes)";
         }
+        uint64_t allowed = AllocationTracker::getAllowedCount() - allowedAtWarmUp;
+        if (allowed) cout << ", plus " << allowed << " allowed";
+        cout << endl;
+        AllocationTracker::printZones();
     }
 };
 
-// ============================================================================
-// ENUMS
-// ============================================================================
+#ifdef ALLOCATION_TRACKER
+void* operator new(size_t size) {
+    AllocationTracker::noteAllocation(size);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
 
-enum class GameScreen { Intro, Menu, Instructions, Gameplay, Pause, HighScore, GameOver, Victory, BossWarning };
-enum class EnemyType { Alpha, Beta, Gamma, Monster, Phantom, Dragon };
-enum class PowerUpType { Power, Fire, Shield, Lives, Nuke, MultiShot, Slow, Danger };
+void* operator new[](size_t size) {
+    AllocationTracker::noteAllocation(size);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+
+// Out of line, so GCC doesn't see free() meet a new-expression's pointer
+#if defined(__GNUC__)
+#define ALLOCATION_NOINLINE __attribute__((noinline))
+#else
+#define ALLOCATION_NOINLINE
+#endif
+ALLOCATION_NOINLINE void operator delete(void* p) noexcept { free(p); }
+ALLOCATION_NOINLINE void operator delete[](void* p) noexcept { free(p); }
+ALLOCATION_NOINLINE void operator delete(void* p, size_t) noexcept { free(p); }
+ALLOCATION_NOINLINE void operator delete[](void* p, size_t) noexcept { free(p); }
+#endif
 
 // ============================================================================
-// GAME OBJECT BASE CLASS
+// ASSET MANIFEST - Every file the game loads at startup
 // ============================================================================
 
-class GameObject {
-protected:
-    Vector2 position;
-    Vector2 velocity;
-    float rotation;
-    bool active;
-    sf::Sprite sprite;
-    float boundingRadius;
-    float health;
-    float maxHealth;
+// Every asset has a compile-time ID that indexes flat arrays in the managers,
+// so a misspelled asset is a compile error rather than a silent empty lookup.
+// The manifest tables below must list assets in ID order (checked at compile time).
+enum class TextureId {
+    // Player
+    Spaceship,
+    PlayerBullet,
+    ShieldEffect,
+
+    // Enemies
+    EnemyAlpha,
+    EnemyBeta,
+    EnemyGamma,
+    EnemyMonster,
+    EnemyPhantom,
+    EnemyDragon,
+    EnemyBullet,
+
+    // Boss
+    Boss,
+    BossEye,
+    BossBullet,
+
+    // Power-ups
+    PowerupPower,
+    PowerupFire,
+    PowerupShield,
+    PowerupLives,
+    PowerupNuke,
+    PowerupMultishot,
+    PowerupSlow,
+    PowerupDanger,
+
+    // Effects
+    Explosion,
 
-public:
-    GameObject() : position(0, 0), velocity(0, 0), rotation(0), active(true), boundingRadius(20), health(100), maxHealth(100) {}
-    virtual ~GameObject() = default;
+    // Backgrounds
+    Background,
+    MenuBackground,
+    BossBackground,
 
-    virtual void update(float dt) {
-        position = position + velocity * dt;
-        sprite.setPosition(position.x, position.y);
-        sprite.setRotation(rotation);
-    }
+    // UI
+    Logo,
+    IntroVideo,
 
-    virtual void draw(sf::RenderWindow& window) {
-        if (active) window.draw(sprite);
-    }
+    Count
+};
 
-    virtual void drawHealthBar(sf::RenderWindow& window, float width = 40.0f, float offsetY = -30.0f) {
-        if (!active || health >= maxHealth) return;
+enum class SoundId {
+    Shoot,
+    Explosion,
+    Powerup,
+    Hit,
+    BossHit,
+    PlayerHurt,
+    LevelUp,
+    GameOver,
+    Victory,
+
+    Count
+};
 
-        float barHeight = 6.0f;
-        float healthPercent = health / maxHealth;
+const size_t TEXTURE_COUNT = static_cast<size_t>(TextureId::Count);
+const size_t SOUND_COUNT = static_cast<size_t>(SoundId::Count);
 
-        // Background
-        sf::RectangleShape bg(sf::Vector2f(width, barHeight));
-        bg.setPosition(position.x - width / 2, position.y + offsetY);
-        bg.setFillColor(sf::Color(60, 60, 60));
-        bg.setOutlineColor(sf::Color::Black);
-        bg.setOutlineThickness(1);
-        window.draw(bg);
+// Atlas images are packed into shared pages by TextureManager::buildAtlas();
+// the rest (backgrounds, UI) stay standalone textures.
+struct TextureAsset {
+    TextureId id;
+    const char* name;
+    const char* path;
+    bool atlas;
+};
 
-        // Health bar with color gradient
-        sf::Color healthColor;
-        if (healthPercent > 0.6f) healthColor = sf::Color(50, 205, 50);
-        else if (healthPercent > 0.3f) healthColor = sf::Color(255, 200, 0);
-        else healthColor = sf::Color(220, 50, 50);
+// priority decides who loses a voice when the pool is full (higher wins);
+// maxVoices caps how many copies of the sound may play at once.
+struct SoundAsset {
+    SoundId id;
+    const char* name;
+    const char* path;
+    int priority;
+    int maxVoices;
+};
 
-        sf::RectangleShape bar(sf::Vector2f(width * healthPercent, barHeight));
-        bar.setPosition(position.x - width / 2, position.y + offsetY);
-        bar.setFillColor(healthColor);
-        window.draw(bar);
-    }
+constexpr TextureAsset TEXTURE_ASSETS[] = {
+    // Player
+    { TextureId::Spaceship, "spaceship", "assets/spaceship.png", true },
+    { TextureId::PlayerBullet, "player_bullet", "assets/player_bullet.png", true },
+    { TextureId::ShieldEffect, "shield_effect", "assets/shield_effect.png", true },
+
+    // Enemies
+    { TextureId::EnemyAlpha, "enemy_alpha", "assets/enemy_alpha.png", true },
+    { TextureId::EnemyBeta, "enemy_beta", "assets/enemy_beta.png", true },
+    { TextureId::EnemyGamma, "enemy_gamma", "assets/enemy_gamma.png", true },
+    { TextureId::EnemyMonster, "enemy_monster", "assets/enemy_monster.png", true },
+    { TextureId::EnemyPhantom, "enemy_phantom", "assets/enemy_phantom.png", true },
+    { TextureId::EnemyDragon, "enemy_dragon", "assets/enemy_dragon.gif", true },
+    { TextureId::EnemyBullet, "enemy_bullet", "assets/enemy_bullet.png", true },
+
+    // Boss
+    { TextureId::Boss, "boss", "assets/boss.png", true },
+    { TextureId::BossEye, "boss_eye", "assets/boss_eye.png", true },
+    { TextureId::BossBullet, "boss_bullet", "assets/boss_bullet.png", true },
+
+    // Power-ups
+    { TextureId::PowerupPower, "powerup_power", "assets/powerup_power.png", true },
+    { TextureId::PowerupFire, "powerup_fire", "assets/powerup_fire.png", true },
+    { TextureId::PowerupShield, "powerup_shield", "assets/powerup_shield.png", true },
+    { TextureId::PowerupLives, "powerup_lives", "assets/powerup_lives.png", true },
+    { TextureId::PowerupNuke, "powerup_nuke", "assets/powerup_nuke.png", true },
+    { TextureId::PowerupMultishot, "powerup_multishot", "assets/powerup_multishot.png", true },
+    { TextureId::PowerupSlow, "powerup_slow", "assets/powerup_slow.png", true },
+    { TextureId::PowerupDanger, "powerup_danger", "assets/powerup_danger.png", true },
+
+    // Effects
+    { TextureId::Explosion, "explosion", "assets/explosion.png", true },
 
-    bool checkCollision(GameObject* other) const {
-        if (!active || !other->isActive()) return false;
-        return position.distanceTo(other->getPosition()) < (boundingRadius + other->getBoundingRadius());
-    }
+    // Backgrounds
+    { TextureId::Background, "background", "assets/background.png", false },
+    { TextureId::MenuBackground, "menu_background", "assets/menu_background.png", false },
+    { TextureId::BossBackground, "boss_background", "assets/boss_background.png", false },
 
-    // Accessors
-    bool isActive() const { return active; }
-    void setActive(bool a) { active = a; }
-    Vector2 getPosition() const { return position; }
-    void setPosition(const Vector2& p) { position = p; sprite.setPosition(p.x, p.y); }
-    Vector2 getVelocity() const { return velocity; }
-    void setVelocity(const Vector2& v) { velocity = v; }
-    float getRotation() const { return rotation; }
-    void setRotation(float r) { rotation = r; sprite.setRotation(r); }
-    float getBoundingRadius() const { return boundingRadius; }
-    void setBoundingRadius(float r) { boundingRadius = r; }
-    float getHealth() const { return health; }
-    float getMaxHealth() const { return maxHealth; }
-    void setHealth(float h) { health = h; }
-    void setMaxHealth(float h) { maxHealth = h; }
+    // UI
+    { TextureId::Logo, "logo", "assets/logo.png", false },
+    { TextureId::IntroVideo, "intro_video", "assets/intro_video.png", false }
+};
 
-    void setupSprite(const string& textureName, float scale = 1.0f) {
-        TextureManager& tm = TextureManager::getInstance();
-        if (tm.hasTexture(textureName)) {
-            sprite.setTexture(tm.getTexture(textureName));
-            sprite.setOrigin(sprite.getTexture()->getSize().x / 2.0f, sprite.getTexture()->getSize().y / 2.0f);
-            sprite.setScale(scale, scale);
-            boundingRadius = (sprite.getTexture()->getSize().x * scale) / 2.5f;
-        }
-    }
+constexpr SoundAsset SOUND_ASSETS[] = {
+    { SoundId::Shoot, "shoot", "assets/shoot.wav", 1, 4 },
+    { SoundId::Explosion, "explosion", "assets/explosion.wav", 2, 6 },
+    { SoundId::Powerup, "powerup", "assets/powerup.wav", 3, 2 },
+    { SoundId::Hit, "hit", "assets/hit.wav", 1, 4 },
+    { SoundId::BossHit, "boss_hit", "assets/boss_hit.wav", 2, 3 },
+    { SoundId::PlayerHurt, "player_hurt", "assets/player_hurt.wav", 3, 2 },
+    { SoundId::LevelUp, "level_up", "assets/level_up.wav", 4, 1 },
+    { SoundId::GameOver, "game_over", "assets/game_over.wav", 5, 1 },
+    { SoundId::Victory, "victory", "assets/victory.wav", 5, 1 }
 };
 
-// ============================================================================
-// BULLET CLASS
+template <typename Asset, size_t N>
+constexpr bool manifestInIdOrder(const Asset (&assets)[N]) {
+    for (size_t i = 0; i < N; i++) {
+        if (static_cast<size_t>(assets[i].id) != i) return false;
+    }
+    return true;
+}
+
+static_assert(size(TEXTURE_ASSETS) == TEXTURE_COUNT && manifestInIdOrder(TEXTURE_ASSETS),
+    "TEXTURE_ASSETS must list every TextureId in order");
+static_assert(size(SOUND_ASSETS) == SOUND_COUNT && manifestInIdOrder(SOUND_ASSETS),
+    "SOUND_ASSETS must list every SoundId in order");
+
+inline size_t toIndex(TextureId id) { return static_cast<size_t>(id); }
+inline size_t toIndex(SoundId id) { return static_cast<size_t>(id); }
+
+// Names are kept for logs and for the bundle index
+inline const char* assetName(TextureId id) { return TEXTURE_ASSETS[toIndex(id)].name; }
+inline const char* assetName(SoundId id) { return SOUND_ASSETS[toIndex(id)].name; }
+
+// Load-time only: resolves a name read from a bundle index
+template <typename Asset, size_t N, typename Id>
+bool findAssetId(const Asset (&assets)[N], const string& name, Id& id) {
+    for (const Asset& asset : assets) {
+        if (name == asset.name) {
+            id = asset.id;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Tried in order; the first that opens becomes the game font
+const char* const FONT_PATHS[] = {
+    "assets/font.otf",
+    "C:/Windows/Fonts/arial.ttf",
+    "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+    "/System/Library/Fonts/Helvetica.ttc"
+};
+
+// ============================================================================
+// TEXTURE MANAGER - Loads and manages all game textures
 // ============================================================================
 
-class Bullet : public GameObject {
+// A texture ID resolves to a page (an atlas page or a standalone texture)
+// plus the sub-rectangle the image occupies on it.
+struct TextureRegion {
+    const sf::Texture* texture = nullptr;   // null until the image is loaded
+    sf::IntRect rect;
+};
+
+struct AtlasPlacement {
+    TextureId id;
+    int page;
+    sf::IntRect rect;
+};
+
+class TextureManager {
 private:
-    bool fromPlayer;
-    int damage;
-    bool isBossBullet;
+    array<sf::Texture, TEXTURE_COUNT> textures;     // standalone textures (backgrounds, UI)
+    array<TextureRegion, TEXTURE_COUNT> regions;    // every loaded image, atlas-packed or not
+    array<sf::Vector2u, TEXTURE_COUNT> knownSizes;  // dimensions recorded without loading (headless)
+    vector<pair<TextureId, sf::Image>> pendingAtlasImages;
+    vector<unique_ptr<sf::Texture>> atlasPages;
+    static TextureManager* instance;
 
 public:
-    Bullet(bool playerBullet, int dmg = 10, bool bossBullet = false)
-        : fromPlayer(playerBullet), damage(dmg), isBossBullet(bossBullet) {
+    static constexpr int ATLAS_PAGE_SIZE = 1024;
+    static constexpr int ATLAS_PADDING = 2;      // keeps smoothed neighbours from bleeding in
+
+    // Shelf-pack images, tallest first, into as few pages as needed. Fills one
+    // placement per image in the (sorted) input order; images too big for a page
+    // get page == -1 and are left to the caller.
+    static vector<sf::Image> packAtlas(vector<pair<TextureId, sf::Image>>& images, int pageSize,
+        vector<AtlasPlacement>& placements) {
+        sort(images.begin(), images.end(),
+            [](const auto& a, const auto& b) { return a.second.getSize().y > b.second.getSize().y; });
+
+        vector<sf::Image> pages;
+        int x = ATLAS_PADDING, y = ATLAS_PADDING, shelfHeight = 0;
+        auto startPage = [&]() {
+            pages.emplace_back();
+            pages.back().create(pageSize, pageSize, sf::Color::Transparent);
+            x = ATLAS_PADDING;
+            y = ATLAS_PADDING;
+            shelfHeight = 0;
+        };
+
+        for (const auto& entry : images) {
+            const sf::Image& image = entry.second;
+            int w = static_cast<int>(image.getSize().x);
+            int h = static_cast<int>(image.getSize().y);
+
+            if (w + ATLAS_PADDING * 2 > pageSize || h + ATLAS_PADDING * 2 > pageSize) {
+                placements.push_back({ entry.first, -1, sf::IntRect(0, 0, w, h) });
+                continue;
+            }
+
+            if (pages.empty()) startPage();
+            if (x + w + ATLAS_PADDING > pageSize) {
+                x = ATLAS_PADDING;
+                y += shelfHeight + ATLAS_PADDING;
+                shelfHeight = 0;
+            }
+            if (y + h + ATLAS_PADDING > pageSize) startPage();
 
-        if (bossBullet) {
-            setupSprite("boss_bullet", 1.2f);
+            pages.back().copy(image, x, y);
+            placements.push_back({ entry.first, static_cast<int>(pages.size()) - 1, sf::IntRect(x, y, w, h) });
+            x += w + ATLAS_PADDING;
+            shelfHeight = max(shelfHeight, h);
         }
-        else if (playerBullet) {
-            setupSprite("player_bullet", 0.9f);
+        return pages;
+    }
+
+    void buildAtlas() {
+        ProfileZone zone("TextureManager::buildAtlas");
+        int pageSize = min(ATLAS_PAGE_SIZE, static_cast<int>(sf::Texture::getMaximumSize()));
+        vector<AtlasPlacement> placements;
+        vector<sf::Image> pages = packAtlas(pendingAtlasImages, pageSize, placements);
+
+        vector<const sf::Texture*> uploaded;
+        for (const auto& page : pages) {
+            uploaded.push_back(addAtlasPage(page.getSize().x, page.getSize().y, page.getPixelsPtr()));
         }
-        else {
-            setupSprite("enemy_bullet", 0.7f);
+
+        for (size_t i = 0; i < placements.size(); i++) {
+            const AtlasPlacement& placed = placements[i];
+            if (placed.page < 0) {
+                // Too big for a page: keep it as a standalone texture
+                addImage(placed.id, move(pendingAtlasImages[i].second), false);
+                continue;
+            }
+            addRegion(placed.id, uploaded[placed.page], placed.rect);
         }
-        boundingRadius = 8.0f;
+        cout << "[OK] Packed " << pendingAtlasImages.size() << " sprites into "
+            << pages.size() << " atlas page(s)" << endl;
+        pendingAtlasImages.clear();
     }
 
-    void update(float dt) override {
-        GameObject::update(dt);
-        if (position.x < -50 || position.x > SCREEN_WIDTH + 50 ||
-            position.y < -50 || position.y > SCREEN_HEIGHT + 50) {
-            active = false;
+    static TextureManager& getInstance() {
+        if (!instance) {
+            instance = new TextureManager();
         }
+        return *instance;
     }
 
-    bool isFromPlayer() const { return fromPlayer; }
-    int getDamage() const { return damage; }
-    bool isBoss() const { return isBossBullet; }
-};
+    // Takes an already decoded image. Standalone images are uploaded now; atlas
+    // images wait for buildAtlas(). Must run on the thread that owns the GL context.
+    void addImage(TextureId id, sf::Image&& image, bool atlas) {
+        if (atlas) {
+            pendingAtlasImages.push_back({ id, move(image) });
+            return;
+        }
+        sf::Texture& texture = textures[toIndex(id)];
+        texture.loadFromImage(image);
+        texture.setSmooth(true);
+        sf::Vector2u size = texture.getSize();
+        addRegion(id, &texture, sf::IntRect(0, 0, size.x, size.y));
+    }
 
-// ============================================================================
-// PLAYER SPACESHIP CLASS
-// ============================================================================
+    // Creates a standalone texture straight from RGBA pixels (e.g. a mapped bundle).
+    // Register what it shows with addRegion().
+    const sf::Texture* addTexturePixels(TextureId id, unsigned width, unsigned height, const sf::Uint8* pixels) {
+        sf::Texture& texture = textures[toIndex(id)];
+        texture.create(width, height);
+        texture.update(pixels);
+        texture.setSmooth(true);
+        return &texture;
+    }
 
-class Spaceship : public GameObject {
-private:
-    float shield;
-    float maxShield;
-    float fireRate;
-    float fireTimer;
-    float invincibilityTimer;
-    bool isInvincible;
-    int lives;
-    int score;
-    int combo;
-    float comboTimer;
-    int powerLevel;
-    int multiShotLevel;
-    bool hasShield;
-    ParticleSystem thrustParticles;
-    sf::Sprite shieldSprite;
+    const sf::Texture* addAtlasPage(unsigned width, unsigned height, const sf::Uint8* pixels) {
+        auto texture = make_unique<sf::Texture>();
+        texture->create(width, height);
+        texture->update(pixels);
+        texture->setSmooth(true);
+        atlasPages.push_back(move(texture));
+        return atlasPages.back().get();
+    }
 
-public:
-    Spaceship() : shield(0), maxShield(PLAYER_MAX_SHIELD), fireRate(BASE_FIRE_RATE), fireTimer(0),
-        invincibilityTimer(0), isInvincible(false), lives(3), score(0), combo(0),
-        comboTimer(0), powerLevel(1), multiShotLevel(1), hasShield(false) {
+    void addRegion(TextureId id, const sf::Texture* texture, const sf::IntRect& rect) {
+        regions[toIndex(id)] = { texture, rect };
+    }
 
-        setupSprite("spaceship", 1.2f);
-        health = PLAYER_MAX_HEALTH;
-        maxHealth = PLAYER_MAX_HEALTH;
+    bool loadTexture(TextureId id, bool atlas = false) {
+        const char* filepath = TEXTURE_ASSETS[toIndex(id)].path;
+        sf::Image image;
+        if (image.loadFromFile(filepath)) {
+            addImage(id, move(image), atlas);
+            cout << "[OK] Loaded: " << filepath << endl;
+            return true;
+        }
+        cerr << "[FAIL] Could not load: " << filepath << endl;
+        return false;
+    }
 
-        TextureManager& tm = TextureManager::getInstance();
-        if (tm.hasTexture("shield_effect")) {
-            shieldSprite.setTexture(tm.getTexture("shield_effect"));
-            shieldSprite.setOrigin(shieldSprite.getTexture()->getSize().x / 2.0f,
-                shieldSprite.getTexture()->getSize().y / 2.0f);
-            shieldSprite.setScale(1.2f, 1.2f);
+    // Whole-texture access for standalone textures such as backgrounds.
+    // Empty (size 0) unless hasTexture(id) is true.
+    const sf::Texture& getTexture(TextureId id) const {
+        return textures[toIndex(id)];
+    }
+
+    bool hasTexture(TextureId id) const {
+        return regions[toIndex(id)].texture != nullptr;
+    }
+
+    const TextureRegion* findRegion(TextureId id) const {
+        const TextureRegion& region = regions[toIndex(id)];
+        return region.texture ? &region : nullptr;
+    }
+
+    void setTextureSize(TextureId id, unsigned width, unsigned height) {
+        knownSizes[toIndex(id)] = sf::Vector2u(width, height);
+    }
+
+    // Size of the loaded image, or the one recorded by setTextureSize()
+    bool getTextureSize(TextureId id, sf::Vector2u& size) const {
+        if (const TextureRegion* region = findRegion(id)) {
+            size = sf::Vector2u(abs(region->rect.width), abs(region->rect.height));
+            return true;
         }
+        size = knownSizes[toIndex(id)];
+        return size.x > 0 && size.y > 0;
     }
 
-    void update(float dt) override {
-        GameObject::update(dt);
+    // Points a sprite at an image, centred on its origin
+    bool setupSprite(sf::Sprite& sprite, TextureId id, float scale = 1.0f) const {
+        const TextureRegion* region = findRegion(id);
+        if (!region) return false;
+        sprite.setTexture(*region->texture);
+        sprite.setTextureRect(region->rect);
+        sprite.setOrigin(region->rect.width / 2.0f, region->rect.height / 2.0f);
+        sprite.setScale(scale, scale);
+        return true;
+    }
 
-        // Clamp position to screen
-        position.x = max(30.0f, min(SCREEN_WIDTH - 30.0f, position.x));
-        position.y = max(30.0f, min(SCREEN_HEIGHT - 30.0f, position.y));
+    // Synchronous load of the whole manifest; the game itself goes through AssetLoader
+    void loadAllTextures() {
+        cout << "\n=== Loading Game Assets ===" << endl;
+        for (const TextureAsset& asset : TEXTURE_ASSETS) {
+            loadTexture(asset.id, asset.atlas);
+        }
+        buildAtlas();
+        cout << "=== Asset Loading Complete ===\n" << endl;
+    }
+};
 
-        fireTimer -= dt;
+TextureManager* TextureManager::instance = nullptr;
 
-        if (isInvincible) {
-            invincibilityTimer -= dt;
-            if (invincibilityTimer <= 0) isInvincible = false;
+// ============================================================================
+// SOUND MANAGER - Loads and manages all game sounds
+// ============================================================================
+
+// Sound effects play on a fixed pool of voices, so the same buffer can be
+// heard several times at once. Each sound is capped at its manifest
+// maxVoices; past the cap its own oldest voice is restarted. When the pool is
+// full, the oldest voice of the lowest priority (no higher than the request)
+// is stolen, and if every voice outranks the request it is dropped.
+//
+// playSound() only counts the request; flushSounds() runs once at the end of
+// the frame and starts one voice per sound, louder the more it was triggered.
+//
+// Music plays on two decks. The next track is opened on a background thread
+// into the idle deck (prefetchMusic), and playMusic switches to it from
+// updateMusic() with a crossfade once it is open, so no frame waits on the
+// file. Set asyncMusic off to get the old blocking open for comparison.
+class SoundManager {
+private:
+    struct Voice {
+        sf::Sound sound;
+        SoundId id = SoundId::Count;     // Count = never used
+        int priority = 0;
+        uint64_t startOrder = 0;
+    };
+
+    // Everything that needs the audio device; absent when it is disabled
+    struct Output {
+        array<Voice, SOUND_VOICE_COUNT> voices;
+        array<sf::Music, 2> musicDecks;
+    };
+
+    array<sf::SoundBuffer, SOUND_COUNT> buffers;
+    array<bool, SOUND_COUNT> loaded{};
+    unique_ptr<Output> output;
+    array<int, SOUND_COUNT> pendingCounts{};
+    uint64_t playCounter = 0;
+    int coalescedSounds = 0;
+    int peakActiveVoices = 0;
+    int stolenVoices = 0;
+    int droppedSounds = 0;
+    array<string, 2> deckPaths;          // track open on each deck, empty if none
+    int activeDeck = 0;
+    future<bool> deckLoad;               // opening the idle deck, when valid()
+    string loadingPath;
+    string queuedPrefetch;               // waits until the idle deck is free
+    string switchPath;                   // track playMusic() asked for
+    bool switchPending = false;
+    bool switchLoop = true;
+    float fadeTimer = 0;                 // > 0 while crossfading
+    bool asyncMusic = true;
+    bool soundEnabled;
+    float masterVolume;
+    static SoundManager* instance;
+    static bool outputEnabled;
+
+    void startVoice(Voice& voice, SoundId id, int priority, float volume) {
+        if (voice.id != id) {
+            voice.sound.setBuffer(buffers[toIndex(id)]);
+            voice.id = id;
         }
+        voice.priority = priority;
+        voice.startOrder = ++playCounter;
+        voice.sound.setVolume(volume);
+        voice.sound.play();
+    }
 
-        // Combo timer
-        if (combo > 0) {
-            comboTimer -= dt;
-            if (comboTimer <= 0) combo = 0;
+    void startSound(SoundId id, float volume) {
+        const SoundAsset& asset = SOUND_ASSETS[toIndex(id)];
+
+        Voice* freeVoice = nullptr;
+        Voice* oldestSame = nullptr;
+        Voice* victim = nullptr;
+        int active = 0, sameCount = 0;
+        for (Voice& voice : output->voices) {
+            if (voice.sound.getStatus() != sf::Sound::Playing) {
+                if (!freeVoice) freeVoice = &voice;
+                continue;
+            }
+            active++;
+            if (voice.id == id) {
+                sameCount++;
+                if (!oldestSame || voice.startOrder < oldestSame->startOrder) oldestSame = &voice;
+            }
+            if (voice.priority <= asset.priority &&
+                (!victim || voice.priority < victim->priority ||
+                    (voice.priority == victim->priority && voice.startOrder < victim->startOrder))) {
+                victim = &voice;
+            }
         }
 
-        // Thrust particles
-        if (velocity.length() > 30.0f) {
-            thrustParticles.emit(position + Vector2(0, 25), Vector2(0, 50),
-                sf::Color(100, 150, 255, 200), 1, 0.3f, 2.0f);
+        if (sameCount >= asset.maxVoices) {
+            startVoice(*oldestSame, id, asset.priority, volume);
+            stolenVoices++;
         }
-        thrustParticles.update(dt);
+        else if (freeVoice) {
+            startVoice(*freeVoice, id, asset.priority, volume);
+            peakActiveVoices = max(peakActiveVoices, active + 1);
+        }
+        else if (victim) {
+            startVoice(*victim, id, asset.priority, volume);
+            stolenVoices++;
+        }
+        else {
+            droppedSounds++;
+        }
+    }
 
-        sprite.setPosition(position.x, position.y);
-        shieldSprite.setPosition(position.x, position.y);
+    int idleDeck() const { return 1 - activeDeck; }
+    float musicVolume() const { return masterVolume * 0.5f; }
+    bool idleDeckBusy() const { return deckLoad.valid() || fadeTimer > 0; }
+    // A deck being opened belongs to the loader thread until updateMusic() collects
+    // it; beginDeckLoad() stopped it first, so there is nothing to stop or pause
+    bool deckLoading(int deck) const { return deck == idleDeck() && deckLoad.valid(); }
+
+    void beginDeckLoad(const string& path) {
+        sf::Music& deck = output->musicDecks[idleDeck()];
+        deck.stop();
+        deckPaths[idleDeck()].clear();
+        loadingPath = path;
+        deckLoad = async(launch::async, [&deck, path] {
+            Profiler::setThreadName("music loader");
+            ProfileZone zone("SoundManager::openMusic");
+            return deck.openFromFile(path);
+        });
     }
 
-    void draw(sf::RenderWindow& window) override {
-        thrustParticles.draw(window);
+    void switchToIdleDeck() {
+        sf::Music& outgoing = output->musicDecks[activeDeck];
+        sf::Music& incoming = output->musicDecks[idleDeck()];
+        bool crossfade = outgoing.getStatus() == sf::Music::Playing;
 
-        if (isInvincible) {
-            float alpha = 150 + sin(invincibilityTimer * 15) * 100;
-            sprite.setColor(sf::Color(255, 255, 255, static_cast<sf::Uint8>(alpha)));
+        incoming.setLoop(switchLoop);
+        incoming.setPlayingOffset(sf::Time::Zero);
+        incoming.setVolume(crossfade ? 0.0f : musicVolume());
+        if (soundEnabled) incoming.play();
+
+        activeDeck = idleDeck();
+        fadeTimer = crossfade ? MUSIC_CROSSFADE_TIME : 0.0f;
+        switchPending = false;
+    }
+
+public:
+    static SoundManager& getInstance() {
+        if (!instance) {
+            instance = new SoundManager();
         }
-        else {
-            sprite.setColor(sf::Color::White);
+        return *instance;
+    }
+
+    SoundManager() : output(outputEnabled ? make_unique<Output>() : nullptr), soundEnabled(true), masterVolume(70.0f) {}
+
+    // For headless runs: call before the first getInstance(), so no voice or
+    // music stream is ever created and the audio device is never opened
+    static void disableOutput() { outputEnabled = false; }
+
+    bool loadSound(SoundId id) {
+        size_t index = toIndex(id);
+        const char* filepath = SOUND_ASSETS[index].path;
+        loaded[index] = buffers[index].loadFromFile(filepath);
+        if (loaded[index]) {
+            cout << "[OK] Loaded sound: " << filepath << endl;
+            return true;
         }
+        cerr << "[FAIL] Could not load sound: " << filepath << endl;
+        return false;
+    }
 
-        GameObject::draw(window);
+    // Takes PCM decoded elsewhere (see AssetLoader), straight into the sound's buffer
+    bool addSamples(SoundId id, const sf::Int16* samples, size_t sampleCount,
+        unsigned channelCount, unsigned sampleRate) {
+        size_t index = toIndex(id);
+        loaded[index] = buffers[index].loadFromSamples(samples, sampleCount, channelCount, sampleRate);
+        return loaded[index];
+    }
 
-        if (hasShield && shield > 0) {
-            float shieldAlpha = (shield / maxShield) * 180.0f;
-            shieldSprite.setColor(sf::Color(100, 200, 255, static_cast<sf::Uint8>(shieldAlpha)));
-            window.draw(shieldSprite);
+    void loadAllSounds() {
+        cout << "\n=== Loading Sound Assets ===" << endl;
+        for (const SoundAsset& asset : SOUND_ASSETS) {
+            loadSound(asset.id);
         }
+        cout << "=== Sound Loading Complete ===\n" << endl;
     }
 
-    void drawHUD(sf::RenderWindow& window, sf::Font& font) {
-        // Health bar
-        float barWidth = 200.0f;
-        float barHeight = 20.0f;
-        float startX = 20.0f;
-        float startY = SCREEN_HEIGHT - 50.0f;
+    void playSound(SoundId id) {
+        size_t index = toIndex(id);
+        if (soundEnabled && loaded[index] && output) pendingCounts[index]++;
+    }
 
-        // Health background
-        sf::RectangleShape healthBg(sf::Vector2f(barWidth, barHeight));
-        healthBg.setPosition(startX, startY);
-        healthBg.setFillColor(sf::Color(40, 40, 40));
-        healthBg.setOutlineColor(sf::Color::White);
-        healthBg.setOutlineThickness(2);
-        window.draw(healthBg);
+    // Call once per frame, after everything that may trigger sounds
+    void flushSounds() {
+        for (size_t index = 0; index < SOUND_COUNT; index++) {
+            int count = pendingCounts[index];
+            if (count == 0) continue;
+            pendingCounts[index] = 0;
+            coalescedSounds += count - 1;
 
-        // Health fill
-        float healthPercent = health / maxHealth;
-        sf::Color healthColor = healthPercent > 0.5f ? sf::Color(50, 200, 50) :
-            healthPercent > 0.25f ? sf::Color(255, 200, 0) : sf::Color(220, 50, 50);
-        sf::RectangleShape healthBar(sf::Vector2f(barWidth * healthPercent, barHeight));
-        healthBar.setPosition(startX, startY);
-        healthBar.setFillColor(healthColor);
-        window.draw(healthBar);
-
-        // Health text
-        sf::Text healthText;
-        healthText.setFont(font);
-        healthText.setString("HP: " + to_string(static_cast<int>(health)) + "/" + to_string(static_cast<int>(maxHealth)));
-        healthText.setCharacterSize(14);
-        healthText.setFillColor(sf::Color::White);
-        healthText.setPosition(startX + 5, startY + 2);
-        window.draw(healthText);
-
-        // Shield bar (if active)
-        if (hasShield) {
-            sf::RectangleShape shieldBg(sf::Vector2f(barWidth, 10.0f));
-            shieldBg.setPosition(startX, startY - 15);
-            shieldBg.setFillColor(sf::Color(20, 20, 60));
-            shieldBg.setOutlineColor(sf::Color(100, 150, 255));
-            shieldBg.setOutlineThickness(1);
-            window.draw(shieldBg);
-
-            sf::RectangleShape shieldBar(sf::Vector2f(barWidth * (shield / maxShield), 10.0f));
-            shieldBar.setPosition(startX, startY - 15);
-            shieldBar.setFillColor(sf::Color(100, 180, 255));
-            window.draw(shieldBar);
-        }
-
-        // Lives
-        sf::Text livesText;
-        livesText.setFont(font);
-        livesText.setString("Lives: " + to_string(lives));
-        livesText.setCharacterSize(20);
-        livesText.setFillColor(sf::Color(255, 100, 100));
-        livesText.setPosition(startX, startY - 40 - (hasShield ? 15 : 0));
-        window.draw(livesText);
-
-        // Score
-        sf::Text scoreText;
-        scoreText.setFont(font);
-        scoreText.setString("Score: " + to_string(score));
-        scoreText.setCharacterSize(24);
-        scoreText.setFillColor(sf::Color(255, 220, 100));
-        scoreText.setPosition(20, 20);
-        window.draw(scoreText);
-
-        // Combo
-        if (combo > 1) {
-            sf::Text comboText;
-            comboText.setFont(font);
-            comboText.setString("COMBO x" + to_string(combo));
-            comboText.setCharacterSize(28);
-            comboText.setFillColor(sf::Color(255, 150, 50));
-            comboText.setPosition(20, 50);
-            window.draw(comboText);
-        }
-
-        // Power level
-        sf::Text powerText;
-        powerText.setFont(font);
-        powerText.setString("Power: " + to_string(powerLevel) + " | Shots: " + to_string(multiShotLevel));
-        powerText.setCharacterSize(16);
-        powerText.setFillColor(sf::Color(150, 200, 255));
-        powerText.setPosition(20, 85);
-        window.draw(powerText);
+            float gain = min(1.0f + SOUND_COALESCE_GAIN_STEP * (count - 1), SOUND_COALESCE_MAX_GAIN);
+            startSound(static_cast<SoundId>(index), min(masterVolume * gain, 100.0f));
+        }
     }
 
-    bool canFire() const { return fireTimer <= 0; }
-    void resetFireTimer() { fireTimer = fireRate; }
+    int getActiveVoiceCount() const {
+        if (!output) return 0;
+        int active = 0;
+        for (const Voice& voice : output->voices) {
+            if (voice.sound.getStatus() == sf::Sound::Playing) active++;
+        }
+        return active;
+    }
 
-    void takeDamage(float dmg) {
-        if (isInvincible) return;
+    int getPeakActiveVoices() const { return peakActiveVoices; }
+    int getStolenVoiceCount() const { return stolenVoices; }
+    int getDroppedSoundCount() const { return droppedSounds; }
+    int getCoalescedSoundCount() const { return coalescedSounds; }
+    int getVoiceCapacity() const { return SOUND_VOICE_COUNT; }
+
+    // Opens a track in the background so a later playMusic() can start it at once.
+    // Paths are taken as literals, so a call without an audio device allocates nothing
+    void prefetchMusic(const char* filepath) {
+        if (!output || !asyncMusic || deckPaths[activeDeck] == filepath) return;
+        if (deckPaths[idleDeck()] == filepath || (deckLoad.valid() && loadingPath == filepath)) return;
+        if (idleDeckBusy()) {
+            queuedPrefetch = filepath;
+            return;
+        }
+        beginDeckLoad(filepath);
+    }
 
-        if (hasShield && shield > 0) {
-            shield -= dmg;
-            if (shield <= 0) {
-                shield = 0;
-                hasShield = false;
+    void playMusic(const char* filepath, bool loop = true) {
+        if (!output) return;
+        ProfileZone zone("SoundManager::playMusic");
+        if (!asyncMusic) {
+            // Blocking open on the calling thread (the behaviour before prefetching)
+            sf::Music& deck = output->musicDecks[activeDeck];
+            if (deck.openFromFile(filepath)) {
+                deckPaths[activeDeck] = filepath;
+                deck.setLoop(loop);
+                deck.setVolume(musicVolume());
+                if (soundEnabled) deck.play();
             }
             return;
         }
 
-        health -= dmg;
-        SoundManager::getInstance().playSound("player_hurt");
+        if (deckPaths[activeDeck] == filepath) {
+            // Already on this track: restart it, as reopening the file used to
+            sf::Music& deck = output->musicDecks[activeDeck];
+            deck.setLoop(loop);
+            deck.setPlayingOffset(sf::Time::Zero);
+            if (soundEnabled) deck.play();
+            switchPending = false;
+            return;
+        }
+        switchPath = filepath;
+        switchLoop = loop;
+        switchPending = true;
+        prefetchMusic(filepath);
+        updateMusic(0);
+    }
 
-        if (health <= 0) {
-            lives--;
-            if (lives > 0) {
-                health = maxHealth;
-                isInvincible = true;
-                invincibilityTimer = 3.0f;
+    // Call once per frame: finishes background opens, starts pending switches, runs the crossfade
+    void updateMusic(float dt) {
+        if (!output) return;
+        if (deckLoad.valid() && deckLoad.wait_for(chrono::seconds(0)) == future_status::ready) {
+            deckPaths[idleDeck()] = deckLoad.get() ? loadingPath : string();
+            if (deckPaths[idleDeck()].empty()) {
+                cerr << "[FAIL] Could not open music: " << loadingPath << endl;
+                if (switchPending && switchPath == loadingPath) switchPending = false;
+            }
+        }
+
+        if (switchPending && !deckLoad.valid() && deckPaths[idleDeck()] == switchPath) {
+            if (fadeTimer > 0) {
+                output->musicDecks[idleDeck()].stop();
+                fadeTimer = 0;
             }
+            switchToIdleDeck();
+        }
+
+        if (fadeTimer > 0) {
+            fadeTimer = max(0.0f, fadeTimer - dt);
+            float t = 1.0f - fadeTimer / MUSIC_CROSSFADE_TIME;
+            output->musicDecks[activeDeck].setVolume(musicVolume() * t);
+            output->musicDecks[idleDeck()].setVolume(musicVolume() * (1.0f - t));
+            if (fadeTimer == 0) output->musicDecks[idleDeck()].stop();
+        }
+
+        if (idleDeckBusy()) return;
+        if (switchPending && deckPaths[idleDeck()] != switchPath) {
+            beginDeckLoad(switchPath);
+        }
+        else if (!queuedPrefetch.empty()) {
+            string path = move(queuedPrefetch);
+            queuedPrefetch.clear();
+            prefetchMusic(path.c_str());
         }
     }
 
-    void addScore(int points) {
-        combo++;
-        comboTimer = 2.0f;
-        int comboMultiplier = min(combo, 10);
-        score += points * comboMultiplier;
+    void stopMusic() {
+        if (!output) return;
+        for (int deck = 0; deck < 2; deck++) {
+            if (!deckLoading(deck)) output->musicDecks[deck].stop();
+        }
+        switchPending = false;
+        fadeTimer = 0;
     }
 
-    void applyPowerUp(PowerUpType type) {
-        SoundManager::getInstance().playSound("powerup");
-        switch (type) {
-        case PowerUpType::Power:
-            powerLevel = min(powerLevel + 1, 5);
-            fireRate = max(fireRate - 0.015f, MIN_FIRE_RATE);
-            break;
-        case PowerUpType::Fire:
-            fireRate = max(fireRate - 0.025f, MIN_FIRE_RATE);
-            break;
-        case PowerUpType::Shield:
-            hasShield = true;
-            shield = maxShield;
-            break;
-        case PowerUpType::Lives:
-            lives++;
-            health = min(health + 30.0f, maxHealth);
-            break;
-        case PowerUpType::MultiShot:
-            multiShotLevel = min(multiShotLevel + 1, 5);
-            break;
-        case PowerUpType::Danger:
-            isInvincible = true;
-            invincibilityTimer = 5.0f;
-            break;
-        default:
-            break;
+    void toggleSound() {
+        soundEnabled = !soundEnabled;
+        if (!output) return;
+        if (!soundEnabled) {
+            for (int deck = 0; deck < 2; deck++) {
+                if (!deckLoading(deck)) output->musicDecks[deck].pause();
+            }
+        }
+        else {
+            // Resume only the current track; a half-finished fade is dropped
+            if (fadeTimer > 0) {
+                output->musicDecks[idleDeck()].stop();
+                fadeTimer = 0;
+            }
+            output->musicDecks[activeDeck].setVolume(musicVolume());
+            output->musicDecks[activeDeck].play();
         }
     }
 
-    void reset() {
-        health = maxHealth;
-        shield = 0;
+    void setAsyncMusic(bool enabled) { asyncMusic = enabled; }
+
+    bool isSoundEnabled() const { return soundEnabled; }
+    void setVolume(float vol) { masterVolume = vol; }
+};
+
+SoundManager* SoundManager::instance = nullptr;
+bool SoundManager::outputEnabled = true;
+
+// ============================================================================
+// ASSET BUNDLE - Pre-decoded assets in one memory-mapped file
+// ============================================================================
+
+// Layout (little-endian): BundleHeader, then entryCount BundleEntry records,
+// then each entry's payload at a 64-byte aligned offset. Payloads are ready to
+// use as-is: RGBA8 pixels, interleaved 16-bit PCM, or raw font file bytes.
+// Every entry made from a source file records that file's modification time;
+// an asset whose loose file has changed since is loaded from disk instead.
+// Build it with: SpaceShooter --pack-assets [path]
+
+const char* const ASSET_BUNDLE_PATH = "assets/assets.bundle";
+const uint32_t BUNDLE_VERSION = 2;
+
+enum BundleEntryType : uint32_t {
+    BUNDLE_TEXTURE = 1,   // params: width, height
+    BUNDLE_REGION = 2,    // params: texture entry index, left, top, width, height (no payload)
+    BUNDLE_SOUND = 3,     // params: channel count, sample rate
+    BUNDLE_FONT = 4       // params: index into FONT_PATHS of the packed file
+};
+
+struct BundleHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+};
+
+struct BundleEntry {
+    char name[32];
+    uint32_t type;
+    uint32_t params[5];
+    uint64_t offset;
+    uint64_t size;
+    int64_t sourceTime;   // source file mtime when packed; -1 for atlas pages
+};
+
+static_assert(sizeof(BundleHeader) == 16, "bundle header layout");
+static_assert(sizeof(BundleEntry) == 80, "bundle entry layout");
+
+// Seconds since the epoch, or -1 if the file can't be found
+int64_t fileModifiedTime(const char* path) {
+    struct stat info;
+    if (stat(path, &info) != 0) return -1;
+    return static_cast<int64_t>(info.st_mtime);
+}
+
+// A missing source file is fine (a release may ship only the bundle);
+// one changed after packing is not
+bool isSourceNewer(const BundleEntry& entry, const char* path) {
+    return fileModifiedTime(path) > entry.sourceTime;
+}
+
+// The packed font is stale if its file changed, or if a file earlier in
+// FONT_PATHS, which would now be preferred, has appeared
+bool isFontEntryStale(const BundleEntry& entry) {
+    size_t packed = entry.params[0];
+    if (packed >= size(FONT_PATHS)) return true;
+    for (size_t i = 0; i < packed; i++) {
+        if (fileModifiedTime(FONT_PATHS[i]) >= 0) return true;
+    }
+    return isSourceNewer(entry, FONT_PATHS[packed]);
+}
+
+// Read-only view of a whole file
+class MappedFile {
+private:
+    const sf::Uint8* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mappingHandle = nullptr;
+#endif
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const string& path) {
+        close();
+#ifdef _WIN32
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+            close();
+            return false;
+        }
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mappingHandle) {
+            close();
+            return false;
+        }
+        bytes = static_cast<const sf::Uint8*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        length = static_cast<size_t>(fileSize.QuadPart);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);   // the mapping keeps its own reference
+        if (mapped == MAP_FAILED) return false;
+        bytes = static_cast<const sf::Uint8*>(mapped);
+        length = static_cast<size_t>(info.st_size);
+#endif
+        if (!bytes) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (bytes) UnmapViewOfFile(bytes);
+        if (mappingHandle) CloseHandle(mappingHandle);
+        if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+        mappingHandle = nullptr;
+        fileHandle = INVALID_HANDLE_VALUE;
+#else
+        if (bytes) munmap(const_cast<sf::Uint8*>(bytes), length);
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+    const sf::Uint8* data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+class AssetBundle {
+private:
+    MappedFile file;
+    const BundleEntry* entries = nullptr;
+    uint32_t entryCount = 0;
+
+    bool validate() const {
+        for (uint32_t i = 0; i < entryCount; i++) {
+            const BundleEntry& entry = entries[i];
+            if (memchr(entry.name, '\0', sizeof(entry.name)) == nullptr) return false;
+            if (entry.offset > file.size() || entry.size > file.size() - entry.offset) return false;
+            switch (entry.type) {
+            case BUNDLE_TEXTURE:
+                if (uint64_t(entry.params[0]) * entry.params[1] * 4 != entry.size) return false;
+                break;
+            case BUNDLE_REGION:
+                if (entry.params[0] >= entryCount || entries[entry.params[0]].type != BUNDLE_TEXTURE) return false;
+                break;
+            case BUNDLE_SOUND:
+                if (entry.params[0] == 0 || entry.offset % 2 != 0) return false;
+                break;
+            case BUNDLE_FONT:
+                break;
+            default:
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    bool open(const string& path) {
+        if (!file.open(path)) return false;
+
+        const BundleHeader* header = reinterpret_cast<const BundleHeader*>(file.data());
+        bool ok = file.size() >= sizeof(BundleHeader) &&
+            memcmp(header->magic, "SSAB", 4) == 0 &&
+            header->version == BUNDLE_VERSION &&
+            header->entryCount <= (file.size() - sizeof(BundleHeader)) / sizeof(BundleEntry);
+        if (ok) {
+            entries = reinterpret_cast<const BundleEntry*>(file.data() + sizeof(BundleHeader));
+            entryCount = header->entryCount;
+            ok = validate();
+        }
+        if (!ok) {
+            cerr << "[FAIL] Asset bundle is corrupt or out of date: " << path << endl;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        file.close();
+        entries = nullptr;
+        entryCount = 0;
+    }
+
+    bool isOpen() const { return entries != nullptr; }
+    uint32_t getEntryCount() const { return entryCount; }
+    const BundleEntry& getEntry(uint32_t index) const { return entries[index]; }
+    const sf::Uint8* getData(const BundleEntry& entry) const { return file.data() + entry.offset; }
+    size_t getMappedSize() const { return file.size(); }
+};
+
+// Collects decoded assets and writes them out in the bundle layout
+class BundleWriter {
+private:
+    vector<BundleEntry> entries;
+    vector<vector<sf::Uint8>> payloads;
+
+    uint32_t addEntry(const string& name, uint32_t type, const void* data, size_t size) {
+        BundleEntry entry = {};
+        if (name.size() >= sizeof(entry.name)) {
+            cerr << "[FAIL] Asset name too long for bundle: " << name << endl;
+        }
+        strncpy(entry.name, name.c_str(), sizeof(entry.name) - 1);
+        entry.type = type;
+        entry.size = size;
+        entry.sourceTime = -1;
+        const sf::Uint8* bytes = static_cast<const sf::Uint8*>(data);
+        payloads.emplace_back(bytes, bytes + size);
+        entries.push_back(entry);
+        return static_cast<uint32_t>(entries.size() - 1);
+    }
+
+public:
+    uint32_t addTexture(const string& name, const sf::Image& image) {
+        sf::Vector2u size = image.getSize();
+        uint32_t index = addEntry(name, BUNDLE_TEXTURE, image.getPixelsPtr(), size_t(size.x) * size.y * 4);
+        entries[index].params[0] = size.x;
+        entries[index].params[1] = size.y;
+        return index;
+    }
+
+    uint32_t addRegion(const string& name, uint32_t textureIndex, const sf::IntRect& rect) {
+        uint32_t index = addEntry(name, BUNDLE_REGION, nullptr, 0);
+        entries[index].params[0] = textureIndex;
+        entries[index].params[1] = static_cast<uint32_t>(rect.left);
+        entries[index].params[2] = static_cast<uint32_t>(rect.top);
+        entries[index].params[3] = static_cast<uint32_t>(rect.width);
+        entries[index].params[4] = static_cast<uint32_t>(rect.height);
+        return index;
+    }
+
+    uint32_t addSound(const string& name, const vector<sf::Int16>& samples,
+        unsigned channelCount, unsigned sampleRate) {
+        uint32_t index = addEntry(name, BUNDLE_SOUND, samples.data(), samples.size() * sizeof(sf::Int16));
+        entries[index].params[0] = channelCount;
+        entries[index].params[1] = sampleRate;
+        return index;
+    }
+
+    uint32_t addFont(const string& name, const vector<char>& bytes, size_t fontPathIndex) {
+        uint32_t index = addEntry(name, BUNDLE_FONT, bytes.data(), bytes.size());
+        entries[index].params[0] = static_cast<uint32_t>(fontPathIndex);
+        return setSource(index, FONT_PATHS[fontPathIndex]);
+    }
+
+    // Records the file an entry was made from, for the staleness check at load
+    uint32_t setSource(uint32_t index, const char* path) {
+        entries[index].sourceTime = fileModifiedTime(path);
+        return index;
+    }
+
+    bool write(const string& path) {
+        uint64_t offset = sizeof(BundleHeader) + entries.size() * sizeof(BundleEntry);
+        for (size_t i = 0; i < entries.size(); i++) {
+            offset = (offset + 63) & ~uint64_t(63);
+            entries[i].offset = offset;
+            offset += entries[i].size;
+        }
+
+        ofstream out(path, ios::binary);
+        if (!out) {
+            cerr << "[FAIL] Could not write bundle: " << path << endl;
+            return false;
+        }
+        BundleHeader header = { { 'S', 'S', 'A', 'B' }, BUNDLE_VERSION,
+            static_cast<uint32_t>(entries.size()), 0 };
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(BundleEntry));
+
+        const char padding[64] = {};
+        uint64_t written = sizeof(BundleHeader) + entries.size() * sizeof(BundleEntry);
+        for (size_t i = 0; i < entries.size(); i++) {
+            out.write(padding, static_cast<streamsize>(entries[i].offset - written));
+            out.write(reinterpret_cast<const char*>(payloads[i].data()), payloads[i].size());
+            written = entries[i].offset + entries[i].size;
+        }
+        if (!out) {
+            cerr << "[FAIL] Could not write bundle: " << path << endl;
+            return false;
+        }
+        cout << "[OK] Wrote " << entries.size() << " entries (" << written / 1024 << " KB) to " << path << endl;
+        return true;
+    }
+};
+
+bool decodeSoundFile(const string& path, vector<sf::Int16>& samples,
+    unsigned& channelCount, unsigned& sampleRate) {
+    sf::InputSoundFile file;
+    if (!file.openFromFile(path)) return false;
+    samples.resize(static_cast<size_t>(file.getSampleCount()));
+    samples.resize(static_cast<size_t>(file.read(samples.data(), samples.size())));
+    channelCount = file.getChannelCount();
+    sampleRate = file.getSampleRate();
+    return !samples.empty();
+}
+
+// Returns the path that was read, or an empty string. The search starts at
+// FONT_PATHS[next] and leaves next past the file that was read, so a caller
+// whose font fails to parse can carry on with the remaining candidates.
+string readFontFile(vector<char>& bytes, size_t& next) {
+    for (; next < size(FONT_PATHS); next++) {
+        ifstream file(FONT_PATHS[next], ios::binary);
+        if (!file) continue;
+        bytes.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        if (!bytes.empty()) return FONT_PATHS[next++];
+    }
+    return string();
+}
+
+string readFontFile(vector<char>& bytes) {
+    size_t next = 0;
+    return readFontFile(bytes, next);
+}
+
+// Decodes every manifest asset from the loose files and writes the bundle.
+// The atlas is packed here too, so the game only uploads finished pages.
+bool packAssetBundle(const string& outputPath) {
+    cout << "\n=== Packing Asset Bundle ===" << endl;
+    BundleWriter writer;
+    vector<pair<TextureId, sf::Image>> atlasImages;
+
+    for (const TextureAsset& asset : TEXTURE_ASSETS) {
+        sf::Image image;
+        if (!image.loadFromFile(asset.path)) {
+            cerr << "[FAIL] Could not load: " << asset.path << endl;
+            continue;
+        }
+        cout << "[OK] Loaded: " << asset.path << endl;
+        if (asset.atlas) {
+            atlasImages.push_back({ asset.id, move(image) });
+            continue;
+        }
+        sf::Vector2u size = image.getSize();
+        uint32_t texture = writer.setSource(writer.addTexture(asset.name, image), asset.path);
+        writer.setSource(writer.addRegion(asset.name, texture, sf::IntRect(0, 0, size.x, size.y)), asset.path);
+    }
+
+    vector<AtlasPlacement> placements;
+    vector<sf::Image> pages = TextureManager::packAtlas(atlasImages, TextureManager::ATLAS_PAGE_SIZE, placements);
+    vector<uint32_t> pageEntries;
+    for (size_t i = 0; i < pages.size(); i++) {
+        pageEntries.push_back(writer.addTexture("atlas_page_" + to_string(i), pages[i]));
+    }
+    for (size_t i = 0; i < placements.size(); i++) {
+        const AtlasPlacement& placed = placements[i];
+        const TextureAsset& asset = TEXTURE_ASSETS[toIndex(placed.id)];
+        if (placed.page < 0) {
+            uint32_t texture = writer.setSource(writer.addTexture(asset.name, atlasImages[i].second), asset.path);
+            writer.setSource(writer.addRegion(asset.name, texture, placed.rect), asset.path);
+        }
+        else {
+            writer.setSource(writer.addRegion(asset.name, pageEntries[placed.page], placed.rect), asset.path);
+        }
+    }
+    cout << "[OK] Packed " << atlasImages.size() << " sprites into " << pages.size() << " atlas page(s)" << endl;
+
+    for (const SoundAsset& asset : SOUND_ASSETS) {
+        vector<sf::Int16> samples;
+        unsigned channelCount = 0, sampleRate = 0;
+        if (!decodeSoundFile(asset.path, samples, channelCount, sampleRate)) {
+            cerr << "[FAIL] Could not load sound: " << asset.path << endl;
+            continue;
+        }
+        writer.setSource(writer.addSound(asset.name, samples, channelCount, sampleRate), asset.path);
+        cout << "[OK] Loaded sound: " << asset.path << endl;
+    }
+
+    vector<char> fontBytes;
+    size_t nextFontPath = 0;
+    string fontPath = readFontFile(fontBytes, nextFontPath);
+    if (!fontPath.empty()) {
+        writer.addFont("font", fontBytes, nextFontPath - 1);
+        cout << "[OK] Loaded font: " << fontPath << endl;
+    }
+    else {
+        cerr << "[FAIL] No font found" << endl;
+    }
+
+    return writer.write(outputPath);
+}
+
+// ============================================================================
+// ASSET LOADER - Decodes assets on worker threads while the intro runs
+// ============================================================================
+
+// Image and sound files are decoded into sf::Image / PCM on a small worker
+// pool. Finished jobs are handed back to the main thread, which owns the GL
+// context and performs the texture uploads in pump(), a few per frame.
+// When an asset bundle is present nothing needs decoding: the workers only
+// fault the mapped pages in, and uploads read straight from the mapping.
+class AssetLoader {
+public:
+    enum class Kind { Texture, Sound, Font };
+
+    struct Job {
+        Kind kind = Kind::Texture;
+        string name;
+        string path;
+        int assetIndex = -1;     // TextureId / SoundId; -1 for the font and bundle atlas pages
+        bool atlas = false;
+        bool ok = false;
+
+        // Decoded payload, written by a worker and consumed by pump()
+        sf::Image image;
+        vector<sf::Int16> samples;
+        unsigned channelCount = 0;
+        unsigned sampleRate = 0;
+        vector<char> bytes;
+        size_t nextFontPath = 0;              // FONT_PATHS index to resume from
+        const BundleEntry* entry = nullptr;   // set when loading from the bundle
+
+        double decodeMs = 0;
+        double uploadMs = 0;
+    };
+
+private:
+    AssetBundle bundle;               // mapped for as long as the loader lives (the font reads from it)
+    vector<const sf::Texture*> bundleTextures;   // by bundle entry index, for resolving regions
+    vector<Job> jobs;                 // fixed once the workers start
+    vector<thread> workers;
+    mutex queueMutex;
+    size_t nextJob = 0;               // guarded by queueMutex
+    deque<size_t> finished;           // guarded by queueMutex
+    size_t uploaded = 0;
+    double atlasMs = 0;
+    bool complete = false;
+    vector<bool> texturesFromDisk;    // by TextureId: stale or missing in the bundle
+    bool looseAtlasImages = false;    // some of those still need packing by buildAtlas()
+    chrono::steady_clock::time_point startTime;
+
+    static double millisecondsSince(chrono::steady_clock::time_point start) {
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+
+    void decode(Job& job) const {
+        ProfileZone zone("AssetLoader::decode");
+        auto start = chrono::steady_clock::now();
+        if (job.entry) {
+            // Touch one byte per page so the main thread doesn't take the faults
+            const volatile sf::Uint8* data = bundle.getData(*job.entry);
+            sf::Uint8 sink = 0;
+            for (uint64_t i = 0; i < job.entry->size; i += 4096) sink ^= data[i];
+            (void)sink;
+            job.ok = true;
+            job.decodeMs = millisecondsSince(start);
+            return;
+        }
+        switch (job.kind) {
+        case Kind::Texture:
+            job.ok = job.image.loadFromFile(job.path);
+            break;
+        case Kind::Sound:
+            job.ok = decodeSoundFile(job.path, job.samples, job.channelCount, job.sampleRate);
+            break;
+        case Kind::Font: {
+            // sf::Font parses lazily from memory, so reading the file is the off-thread part
+            string path = readFontFile(job.bytes, job.nextFontPath);
+            job.ok = !path.empty();
+            if (job.ok) job.path = path;
+            break;
+        }
+        }
+        job.decodeMs = millisecondsSince(start);
+    }
+
+    void workerLoop() {
+        Profiler::setThreadName("asset loader");
+        while (true) {
+            size_t index;
+            {
+                lock_guard<mutex> lock(queueMutex);
+                if (nextJob >= jobs.size()) return;
+                index = nextJob++;
+            }
+            decode(jobs[index]);
+            lock_guard<mutex> lock(queueMutex);
+            finished.push_back(index);
+        }
+    }
+
+    void addJob(Kind kind, const string& name, const string& path, int assetIndex = -1, bool atlas = false) {
+        jobs.emplace_back();
+        Job& job = jobs.back();
+        job.kind = kind;
+        job.name = name;
+        job.path = path;
+        job.assetIndex = assetIndex;
+        job.atlas = atlas;
+    }
+
+    void uploadMapped(Job& job, sf::Font& font, bool& fontLoaded) {
+        const BundleEntry& entry = *job.entry;
+        const sf::Uint8* data = bundle.getData(entry);
+        switch (job.kind) {
+        case Kind::Texture: {
+            TextureManager& tm = TextureManager::getInstance();
+            bundleTextures[job.entry - &bundle.getEntry(0)] = job.assetIndex < 0
+                ? tm.addAtlasPage(entry.params[0], entry.params[1], data)
+                : tm.addTexturePixels(TextureId(job.assetIndex), entry.params[0], entry.params[1], data);
+            break;
+        }
+        case Kind::Sound:
+            job.ok = SoundManager::getInstance().addSamples(SoundId(job.assetIndex), reinterpret_cast<const sf::Int16*>(data),
+                static_cast<size_t>(entry.size / sizeof(sf::Int16)), entry.params[0], entry.params[1]);
+            break;
+        case Kind::Font:
+            job.ok = fontLoaded = font.loadFromMemory(data, static_cast<size_t>(entry.size));
+            break;
+        }
+    }
+
+    void registerBundleRegions() {
+        TextureManager& tm = TextureManager::getInstance();
+        for (uint32_t i = 0; i < bundle.getEntryCount(); i++) {
+            const BundleEntry& entry = bundle.getEntry(i);
+            TextureId id;
+            if (entry.type != BUNDLE_REGION || !findAssetId(TEXTURE_ASSETS, entry.name, id)) continue;
+            if (texturesFromDisk[toIndex(id)]) continue;
+            const sf::Texture* texture = bundleTextures[entry.params[0]];
+            if (!texture) continue;
+            sf::IntRect rect(entry.params[1], entry.params[2], entry.params[3], entry.params[4]);
+            tm.addRegion(id, texture, rect);
+        }
+    }
+
+    void addBundleJobs() {
+        // First work out which assets the bundle still holds: a texture needs a
+        // region entry, and nothing counts if its source file changed since packing
+        vector<bool> soundsFromDisk(size(SOUND_ASSETS), true);
+        texturesFromDisk.assign(size(TEXTURE_ASSETS), true);
+        bool fontFromDisk = true;
+        for (uint32_t i = 0; i < bundle.getEntryCount(); i++) {
+            const BundleEntry& entry = bundle.getEntry(i);
+            TextureId textureId;
+            SoundId soundId;
+            if (entry.type == BUNDLE_REGION && findAssetId(TEXTURE_ASSETS, entry.name, textureId)) {
+                texturesFromDisk[toIndex(textureId)] = isSourceNewer(entry, TEXTURE_ASSETS[toIndex(textureId)].path);
+            }
+            else if (entry.type == BUNDLE_SOUND && findAssetId(SOUND_ASSETS, entry.name, soundId)) {
+                soundsFromDisk[toIndex(soundId)] = isSourceNewer(entry, SOUND_ASSETS[toIndex(soundId)].path);
+            }
+            else if (entry.type == BUNDLE_FONT) {
+                fontFromDisk = isFontEntryStale(entry);
+            }
+        }
+
+        // Font first, as with loose files; regions carry no data and are registered at the end.
+        // Textures without an ID are atlas pages; sounds without one are unknown and skipped.
+        bundleTextures.assign(bundle.getEntryCount(), nullptr);
+        if (fontFromDisk) addJob(Kind::Font, "font", FONT_PATHS[0]);
+        for (uint32_t type : { BUNDLE_FONT, BUNDLE_TEXTURE, BUNDLE_SOUND }) {
+            for (uint32_t i = 0; i < bundle.getEntryCount(); i++) {
+                const BundleEntry& entry = bundle.getEntry(i);
+                if (entry.type != type) continue;
+
+                Kind kind = Kind::Font;
+                int assetIndex = -1;
+                if (type == BUNDLE_FONT && fontFromDisk) continue;
+                if (type == BUNDLE_TEXTURE) {
+                    kind = Kind::Texture;
+                    TextureId id;
+                    if (findAssetId(TEXTURE_ASSETS, entry.name, id)) {
+                        assetIndex = static_cast<int>(toIndex(id));
+                        if (texturesFromDisk[assetIndex]) continue;
+                    }
+                }
+                else if (type == BUNDLE_SOUND) {
+                    kind = Kind::Sound;
+                    SoundId id;
+                    if (!findAssetId(SOUND_ASSETS, entry.name, id)) continue;
+                    assetIndex = static_cast<int>(toIndex(id));
+                    if (soundsFromDisk[assetIndex]) continue;
+                }
+                addJob(kind, entry.name, string(ASSET_BUNDLE_PATH) + ":" + entry.name, assetIndex);
+                jobs.back().entry = &entry;
+            }
+        }
+
+        // Whatever the bundle is missing, or holds an old copy of, comes from the loose file
+        int fromDisk = fontFromDisk ? 1 : 0;
+        for (const TextureAsset& asset : TEXTURE_ASSETS) {
+            if (!texturesFromDisk[toIndex(asset.id)]) continue;
+            addJob(Kind::Texture, asset.name, asset.path, static_cast<int>(toIndex(asset.id)), asset.atlas);
+            looseAtlasImages = looseAtlasImages || asset.atlas;
+            fromDisk++;
+        }
+        for (const SoundAsset& asset : SOUND_ASSETS) {
+            if (!soundsFromDisk[toIndex(asset.id)]) continue;
+            addJob(Kind::Sound, asset.name, asset.path, static_cast<int>(toIndex(asset.id)));
+            fromDisk++;
+        }
+        if (fromDisk > 0) {
+            cout << "[OK] " << fromDisk << " asset(s) missing from or newer than the bundle, loading from disk" << endl;
+        }
+    }
+
+    void upload(Job& job, sf::Font& font, vector<char>& fontData, bool& fontLoaded) {
+        ProfileZone zone("AssetLoader::upload");
+        auto start = chrono::steady_clock::now();
+        if (job.ok && job.entry) {
+            uploadMapped(job, font, fontLoaded);
+        }
+        else if (job.ok) {
+            switch (job.kind) {
+            case Kind::Texture:
+                TextureManager::getInstance().addImage(TextureId(job.assetIndex), move(job.image), job.atlas);
+                break;
+            case Kind::Sound:
+                job.ok = SoundManager::getInstance().addSamples(SoundId(job.assetIndex), job.samples.data(),
+                    job.samples.size(), job.channelCount, job.sampleRate);
+                job.samples = vector<sf::Int16>();
+                break;
+            case Kind::Font:
+                // The font keeps reading from this buffer, so it lives with the font.
+                // A file sf::Font rejects falls through to the next candidate
+                fontData = move(job.bytes);
+                job.ok = fontLoaded = font.loadFromMemory(fontData.data(), fontData.size());
+                while (!job.ok) {
+                    cerr << "[FAIL] Could not load: " << job.path << endl;
+                    string path = readFontFile(fontData, job.nextFontPath);
+                    if (path.empty()) break;
+                    job.path = path;
+                    job.ok = fontLoaded = font.loadFromMemory(fontData.data(), fontData.size());
+                }
+                break;
+            }
+        }
+        job.uploadMs = millisecondsSince(start);
+
+        if (job.ok) cout << "[OK] Loaded: " << job.path << endl;
+        else cerr << "[FAIL] Could not load: " << job.path << endl;
+    }
+
+public:
+    AssetLoader() = default;
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    ~AssetLoader() {
+        for (auto& worker : workers) worker.join();
+    }
+
+    void start() {
+        startTime = chrono::steady_clock::now();
+        cout << "\n=== Loading Game Assets ===" << endl;
+
+        jobs.clear();
+        looseAtlasImages = false;
+        if (bundle.open(ASSET_BUNDLE_PATH)) {
+            cout << "[OK] Using asset bundle: " << ASSET_BUNDLE_PATH << endl;
+            addBundleJobs();
+        }
+        else {
+            // Font first: the intro text needs it long before the sprites
+            addJob(Kind::Font, "font", FONT_PATHS[0]);
+            for (const TextureAsset& asset : TEXTURE_ASSETS) {
+                addJob(Kind::Texture, asset.name, asset.path, static_cast<int>(toIndex(asset.id)), asset.atlas);
+            }
+            for (const SoundAsset& asset : SOUND_ASSETS) {
+                addJob(Kind::Sound, asset.name, asset.path, static_cast<int>(toIndex(asset.id)));
+            }
+        }
+
+        unsigned hardware = thread::hardware_concurrency();
+        unsigned threadCount = max(1u, min(4u, hardware > 1 ? hardware - 1 : 1u));
+        for (unsigned i = 0; i < threadCount; i++) {
+            workers.emplace_back(&AssetLoader::workerLoop, this);
+        }
+    }
+
+    // Main thread: uploads decoded jobs until the time budget runs out.
+    // Returns true once every asset is in place and the atlas is built.
+    bool pump(sf::Font& font, vector<char>& fontData, bool& fontLoaded, double budgetMs = 4.0) {
+        if (complete) return true;
+
+        ProfileZone zone("AssetLoader::pump");
+        auto start = chrono::steady_clock::now();
+        while (uploaded < jobs.size()) {
+            size_t index;
+            {
+                lock_guard<mutex> lock(queueMutex);
+                if (finished.empty()) return false;
+                index = finished.front();
+                finished.pop_front();
+            }
+            upload(jobs[index], font, fontData, fontLoaded);
+            uploaded++;
+            if (millisecondsSince(start) > budgetMs) return false;
+        }
+
+        auto atlasStart = chrono::steady_clock::now();
+        if (bundle.isOpen()) registerBundleRegions();
+        if (!bundle.isOpen() || looseAtlasImages) TextureManager::getInstance().buildAtlas();
+        atlasMs = millisecondsSince(atlasStart);
+
+        for (auto& worker : workers) worker.join();
+        workers.clear();
+        complete = true;
+        cout << "=== Asset Loading Complete ===\n" << endl;
+        printReport();
+        return true;
+    }
+
+    float getProgress() const {
+        return jobs.empty() ? 1.0f : static_cast<float>(uploaded) / jobs.size();
+    }
+
+    size_t getLoadedCount() const { return uploaded; }
+    size_t getTotalCount() const { return jobs.size(); }
+    bool isComplete() const { return complete; }
+
+    void printReport() const {
+        double decodeTotal = 0, uploadTotal = 0;
+        cout << "=== Startup Timing (ms) ===" << endl;
+        cout << "  asset                       decode    upload" << endl;
+        for (const Job& job : jobs) {
+            ostringstream line;
+            line.setf(ios::fixed);
+            line.precision(2);
+            line << "  " << (job.kind == Kind::Texture ? "image " : job.kind == Kind::Sound ? "sound " : "font  ")
+                << job.name;
+            line << string(job.name.size() < 20 ? 20 - job.name.size() : 1, ' ');
+            line.width(9);
+            line << job.decodeMs;
+            line.width(10);
+            line << job.uploadMs;
+            if (!job.ok) line << "  (missing)";
+            cout << line.str() << endl;
+
+            decodeTotal += job.decodeMs;
+            uploadTotal += job.uploadMs;
+        }
+        cout.setf(ios::fixed);
+        cout.precision(2);
+        cout << "  atlas build / bundle regions: " << atlasMs << endl;
+        cout << "  decode total (summed over workers): " << decodeTotal << endl;
+        cout << "  main-thread upload total: " << uploadTotal + atlasMs << endl;
+        cout << "  wall time to ready: " << millisecondsSince(startTime) << endl;
+        cout.unsetf(ios::fixed);
+        cout.precision(6);
+    }
+};
+
+// ============================================================================
+// RANDOM GENERATOR
+// ============================================================================
+
+// xoshiro128** (Blackman & Vigna): 16 bytes of state, a handful of ALU ops per
+// number, no distribution objects. Each subsystem draws from its own stream so
+// that, say, more particles on screen never changes what the enemies do.
+class RandomStream {
+private:
+    uint32_t state[4];
+
+    static uint32_t rotl(uint32_t x, int k) {
+        return (x << k) | (x >> (32 - k));
+    }
+
+    static uint64_t splitMix64(uint64_t& x) {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+public:
+    explicit RandomStream(uint64_t seedValue = 1) { seed(seedValue); }
+
+    void seed(uint64_t seedValue) {
+        uint64_t a = splitMix64(seedValue);
+        uint64_t b = splitMix64(seedValue);
+        state[0] = static_cast<uint32_t>(a);
+        state[1] = static_cast<uint32_t>(a >> 32);
+        state[2] = static_cast<uint32_t>(b);
+        state[3] = static_cast<uint32_t>(b >> 32);
+    }
+
+    uint32_t next() {
+        uint32_t result = rotl(state[1] * 5, 7) * 9;
+        uint32_t t = state[1] << 9;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 11);
+        return result;
+    }
+
+    // [0, 1) from the top 24 bits
+    float nextFloat() {
+        return (next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    float range(float min, float max) {
+        return min + (max - min) * nextFloat();
+    }
+
+    // Inclusive on both ends, like uniform_int_distribution. Lemire's
+    // multiply-shift with rejection, so it stays unbiased without a division
+    // on the common path.
+    int range(int min, int max) {
+        uint32_t span = static_cast<uint32_t>(max) - static_cast<uint32_t>(min) + 1u;
+        if (span == 0) return static_cast<int>(next());   // full 32-bit range
+        uint64_t m = uint64_t(next()) * span;
+        uint32_t low = static_cast<uint32_t>(m);
+        if (low < span) {
+            uint32_t threshold = (0u - span) % span;
+            while (low < threshold) {
+                m = uint64_t(next()) * span;
+                low = static_cast<uint32_t>(m);
+            }
+        }
+        return static_cast<int>(static_cast<uint32_t>(min) + static_cast<uint32_t>(m >> 32));
+    }
+
+    // Bulk version of range(min, max) for batch consumers
+    void fill(float* out, size_t count, float min, float max) {
+        float scale = (max - min) * (1.0f / 16777216.0f);
+        for (size_t i = 0; i < count; i++) {
+            out[i] = min + (next() >> 8) * scale;
+        }
+    }
+};
+
+class RandomGenerator {
+private:
+    enum Stream { GAMEPLAY, PARTICLES, COSMETIC, STREAM_COUNT };
+    static RandomStream streams[STREAM_COUNT];
+    static uint64_t currentSeed;
+
+public:
+    static void seed() {
+        seed(static_cast<uint64_t>(chrono::system_clock::now().time_since_epoch().count()));
+    }
+
+    // Streams are derived from one seed, so a run can be reproduced from it
+    static void seed(uint64_t seedValue) {
+        currentSeed = seedValue;
+        for (int i = 0; i < STREAM_COUNT; i++) {
+            streams[i].seed(seedValue + 0x632BE59BD9B4E019ull * (i + 1));
+        }
+    }
+
+    static uint64_t getSeed() { return currentSeed; }
+
+    // Anything that affects the simulation: spawns, drops, AI timers
+    static RandomStream& gameplay() { return streams[GAMEPLAY]; }
+    // Particle effects
+    static RandomStream& particles() { return streams[PARTICLES]; }
+    // Purely visual extras: starfield, screen shake
+    static RandomStream& cosmetic() { return streams[COSMETIC]; }
+};
+
+RandomStream RandomGenerator::streams[RandomGenerator::STREAM_COUNT];
+uint64_t RandomGenerator::currentSeed = 0;
+
+// ============================================================================
+// VECTOR2 UTILITY CLASS
+// ============================================================================
+
+class Vector2 {
+public:
+    float x, y;
+
+    Vector2() : x(0), y(0) {}
+    Vector2(float x, float y) : x(x), y(y) {}
+
+    Vector2 operator+(const Vector2& other) const { return Vector2(x + other.x, y + other.y); }
+    Vector2 operator-(const Vector2& other) const { return Vector2(x - other.x, y - other.y); }
+    Vector2 operator*(float scalar) const { return Vector2(x * scalar, y * scalar); }
+    Vector2 operator/(float scalar) const { return scalar != 0 ? Vector2(x / scalar, y / scalar) : *this; }
+
+    float length() const { return sqrt(x * x + y * y); }
+    float distanceTo(const Vector2& other) const { return (*this - other).length(); }
+    float distanceSquaredTo(const Vector2& other) const {
+        float dx = x - other.x, dy = y - other.y;
+        return dx * dx + dy * dy;
+    }
+
+    Vector2 normalized() const {
+        float len = length();
+        return len > 0.0001f ? Vector2(x / len, y / len) : Vector2(0, 0);
+    }
+
+    float angle() const { return atan2(y, x) * 180.0f / PI; }
+};
+
+// Draw calls issued this frame, for the performance overlay; free without it
+#ifdef PERF_OVERLAY
+size_t frameDrawCalls = 0;
+inline void countDrawCalls(size_t calls = 1) { frameDrawCalls += calls; }
+#else
+inline void countDrawCalls(size_t = 1) {}
+#endif
+
+template <typename Drawable>
+void drawCounted(sf::RenderTarget& target, const Drawable& drawable) {
+    target.draw(drawable);
+    countDrawCalls();
+}
+
+// ============================================================================
+// POINT SPRITE BATCH - Many small discs in a single draw call
+// ============================================================================
+
+// Writes each disc as a textured quad (two triangles) into one reusable vertex
+// array, so a whole particle system or starfield costs one draw call instead
+// of one sf::CircleShape per element.
+class PointSpriteBatch {
+private:
+    static const unsigned DISC_TEXTURE_SIZE = 64;
+
+    sf::VertexArray vertices;
+    size_t spriteCount;
+
+    // White disc, tinted per vertex. The texels have a hard edge; smoothing
+    // filters it when the disc is scaled down to a few pixels, which reads
+    // closer to a small CircleShape than nearest-texel sampling does
+    static const sf::Texture& getDiscTexture() {
+        static sf::Texture texture;
+        static bool created = false;
+        if (!created) {
+            const unsigned size = DISC_TEXTURE_SIZE;
+            const float radius = size / 2.0f;
+            sf::Image image;
+            image.create(size, size, sf::Color::Transparent);
+            for (unsigned y = 0; y < size; y++) {
+                for (unsigned x = 0; x < size; x++) {
+                    float dx = x + 0.5f - radius;
+                    float dy = y + 0.5f - radius;
+                    if (dx * dx + dy * dy <= radius * radius) image.setPixel(x, y, sf::Color::White);
+                }
+            }
+            texture.loadFromImage(image);
+            texture.setSmooth(true);
+            created = true;
+        }
+        return texture;
+    }
+
+public:
+    PointSpriteBatch() : vertices(sf::Triangles), spriteCount(0) {}
+
+    void clear() { spriteCount = 0; }
+
+    void add(float centerX, float centerY, float radius, const sf::Color& color) {
+        size_t base = spriteCount * 6;
+        if (base + 6 > vertices.getVertexCount()) {
+            vertices.resize(max<size_t>(64 * 6, vertices.getVertexCount() * 2));
+        }
+
+        // Filled on the simulation thread too, so this must not create the texture
+        const float texSize = static_cast<float>(DISC_TEXTURE_SIZE);
+        sf::Vector2f corners[4] = {
+            { centerX - radius, centerY - radius }, { centerX + radius, centerY - radius },
+            { centerX + radius, centerY + radius }, { centerX - radius, centerY + radius }
+        };
+        sf::Vector2f uvs[4] = { { 0, 0 }, { texSize, 0 }, { texSize, texSize }, { 0, texSize } };
+        const int order[6] = { 0, 1, 2, 0, 2, 3 };
+        for (int i = 0; i < 6; i++) {
+            sf::Vertex& v = vertices[base + i];
+            v.position = corners[order[i]];
+            v.texCoords = uvs[order[i]];
+            v.color = color;
+        }
+        spriteCount++;
+    }
+
+    void draw(sf::RenderTarget& window) const {
+        if (spriteCount == 0) return;
+        sf::RenderStates states(&getDiscTexture());
+        window.draw(&vertices[0], spriteCount * 6, sf::Triangles, states);
+        countDrawCalls();
+    }
+
+    size_t getCount() const { return spriteCount; }
+};
+
+// ============================================================================
+// SPRITE BATCH - One draw call per texture page for a layer of sprites
+// ============================================================================
+
+// Collects sprites as transformed, textured quads grouped by texture. With
+// the atlas, a whole layer of enemies, bullets or power-ups shares one page,
+// so flush() issues a single draw call for it. Sprites on different pages are
+// drawn page by page in order of first use.
+class SpriteBatch {
+private:
+    struct PageBatch {
+        const sf::Texture* texture;
+        sf::VertexArray vertices;
+        size_t quadCount;
+    };
+    vector<PageBatch> pages;
+
+    PageBatch& pageFor(const sf::Texture* texture) {
+        for (auto& page : pages) {
+            if (page.texture == texture) return page;
+        }
+        pages.push_back({ texture, sf::VertexArray(sf::Triangles), 0 });
+        return pages.back();
+    }
+
+public:
+    void add(const sf::Sprite& sprite, const sf::Transform& parent = sf::Transform::Identity) {
+        const sf::Texture* texture = sprite.getTexture();
+        if (!texture) return;
+
+        PageBatch& page = pageFor(texture);
+        size_t base = page.quadCount * 6;
+        if (base + 6 > page.vertices.getVertexCount()) {
+            page.vertices.resize(max<size_t>(64 * 6, page.vertices.getVertexCount() * 2));
+        }
+
+        sf::Transform transform = parent * sprite.getTransform();
+        const sf::IntRect& rect = sprite.getTextureRect();
+        float w = static_cast<float>(abs(rect.width));
+        float h = static_cast<float>(abs(rect.height));
+        float left = static_cast<float>(rect.left);
+        float top = static_cast<float>(rect.top);
+        float right = left + rect.width;
+        float bottom = top + rect.height;
+
+        sf::Vector2f corners[4] = {
+            transform.transformPoint(0, 0), transform.transformPoint(w, 0),
+            transform.transformPoint(w, h), transform.transformPoint(0, h)
+        };
+        sf::Vector2f uvs[4] = { { left, top }, { right, top }, { right, bottom }, { left, bottom } };
+        const int order[6] = { 0, 1, 2, 0, 2, 3 };
+        for (int i = 0; i < 6; i++) {
+            sf::Vertex& v = page.vertices[base + i];
+            v.position = corners[order[i]];
+            v.texCoords = uvs[order[i]];
+            v.color = sprite.getColor();
+        }
+        page.quadCount++;
+    }
+
+    // Draws everything collected so far, one call per page, and empties the batch
+    void flush(sf::RenderTarget& window) {
+        for (auto& page : pages) {
+            if (page.quadCount == 0) continue;
+            window.draw(&page.vertices[0], page.quadCount * 6, sf::Triangles, sf::RenderStates(page.texture));
+            countDrawCalls();
+            page.quadCount = 0;
+        }
+    }
+};
+
+// ============================================================================
+// PRIMITIVE BATCH - Rects, outlines, circles and rings in one draw call
+// ============================================================================
+
+// Immediate mode: add shapes while drawing a layer, then flush() once. Each
+// shape goes into one reused, untextured vertex array as triangles, so a layer
+// of health bars, a shield or a screen overlay costs one draw call rather than
+// one sf::RectangleShape / sf::CircleShape (and its geometry rebuild) apiece.
+class PrimitiveBatch {
+private:
+    sf::VertexArray vertices;
+    size_t vertexCount;
+
+    sf::Vertex* append(size_t count) {
+        if (vertexCount + count > vertices.getVertexCount()) {
+            vertices.resize(max(vertexCount + count, max<size_t>(64 * 6, vertices.getVertexCount() * 2)));
+        }
+        sf::Vertex* v = &vertices[vertexCount];
+        vertexCount += count;
+        return v;
+    }
+
+    // Unit-circle points (first one repeated at the end) for a radius: bigger
+    // circles get more segments, and each segment count is computed once
+    static const vector<sf::Vector2f>& unitCircle(float radius) {
+        static map<int, vector<sf::Vector2f>> tables;
+        int segments = max(16, min(64, static_cast<int>(radius / 4) * 4));
+        vector<sf::Vector2f>& points = tables[segments];
+        if (points.empty()) {
+            points.resize(segments + 1);
+            for (int i = 0; i <= segments; i++) {
+                float angle = 2 * PI * (i % segments) / segments;
+                points[i] = sf::Vector2f(cos(angle), sin(angle));
+            }
+        }
+        return points;
+    }
+
+public:
+    PrimitiveBatch() : vertices(sf::Triangles), vertexCount(0) {}
+
+    void addRect(float x, float y, float width, float height, sf::Color color) {
+        if (width <= 0 || height <= 0) return;
+        sf::Vertex* v = append(6);
+        const sf::Vector2f corners[4] = { { x, y }, { x + width, y }, { x + width, y + height }, { x, y + height } };
+        const int order[6] = { 0, 1, 2, 0, 2, 3 };
+        for (int i = 0; i < 6; i++) {
+            v[i].position = corners[order[i]];
+            v[i].color = color;
+        }
+    }
+
+    // The outline lies outside the rect, as with sf::RectangleShape
+    void addOutlinedRect(float x, float y, float width, float height, sf::Color fill,
+        sf::Color outline, float thickness) {
+        addRect(x, y, width, height, fill);
+        addRect(x - thickness, y - thickness, width + 2 * thickness, thickness, outline);
+        addRect(x - thickness, y + height, width + 2 * thickness, thickness, outline);
+        addRect(x - thickness, y, thickness, height, outline);
+        addRect(x + width, y, thickness, height, outline);
+    }
+
+    void addCircle(sf::Vector2f center, float radius, sf::Color color) {
+        const vector<sf::Vector2f>& unit = unitCircle(radius);
+        size_t segments = unit.size() - 1;
+        sf::Vertex* v = append(segments * 3);
+        for (size_t i = 0; i < segments; i++, v += 3) {
+            v[0].position = center;
+            v[1].position = center + unit[i] * radius;
+            v[2].position = center + unit[i + 1] * radius;
+            v[0].color = v[1].color = v[2].color = color;
+        }
+    }
+
+    void addRing(sf::Vector2f center, float innerRadius, float outerRadius, sf::Color color) {
+        const vector<sf::Vector2f>& unit = unitCircle(outerRadius);
+        size_t segments = unit.size() - 1;
+        sf::Vertex* v = append(segments * 6);
+        for (size_t i = 0; i < segments; i++, v += 6) {
+            sf::Vector2f inner0 = center + unit[i] * innerRadius, outer0 = center + unit[i] * outerRadius;
+            sf::Vector2f inner1 = center + unit[i + 1] * innerRadius, outer1 = center + unit[i + 1] * outerRadius;
+            v[0].position = inner0;
+            v[1].position = outer0;
+            v[2].position = outer1;
+            v[3].position = inner0;
+            v[4].position = outer1;
+            v[5].position = inner1;
+            for (int k = 0; k < 6; k++) v[k].color = color;
+        }
+    }
+
+    // Draws everything added so far in one call and empties the batch
+    void flush(sf::RenderTarget& target) {
+        if (vertexCount == 0) return;
+        target.draw(&vertices[0], vertexCount, sf::Triangles);
+        countDrawCalls();
+        vertexCount = 0;
+    }
+
+    size_t getVertexCount() const { return vertexCount; }
+};
+
+// ============================================================================
+// PARTICLE SYSTEM
+// ============================================================================
+
+// Structure-of-arrays particle store. Every attribute lives in its own
+// contiguous array so the update loop is a set of straight float streams the
+// compiler can vectorize. Live particles always occupy [0, count): dead ones
+// are compacted out on every update, wherever they sit, keeping emission order.
+class ParticleSystem {
+private:
+    vector<float> posX, posY;
+    vector<float> velX, velY;
+    vector<float> lifetime;
+    vector<float> invMaxLifetime;
+    vector<float> sizes;
+    vector<float> rotation;
+    vector<float> rotationSpeed;
+    vector<sf::Color> colors;
+    size_t liveCount;
+    size_t capacity;
+    PointSpriteBatch batch;
+
+    void spawn(const Vector2& pos, const Vector2& vel, const sf::Color& col, float life, float sz) {
+        size_t i = liveCount++;
+        posX[i] = pos.x;
+        posY[i] = pos.y;
+        velX[i] = vel.x;
+        velY[i] = vel.y;
+        life = max(life, MIN_PARTICLE_LIFETIME);
+        lifetime[i] = life;
+        invMaxLifetime[i] = 1.0f / life;
+        sizes[i] = sz;
+        rotation[i] = 0;
+        colors[i] = col;
+    }
+
+    void copyParticle(size_t from, size_t to) {
+        posX[to] = posX[from];
+        posY[to] = posY[from];
+        velX[to] = velX[from];
+        velY[to] = velY[from];
+        lifetime[to] = lifetime[from];
+        invMaxLifetime[to] = invMaxLifetime[from];
+        sizes[to] = sizes[from];
+        rotation[to] = rotation[from];
+        rotationSpeed[to] = rotationSpeed[from];
+        colors[to] = colors[from];
+    }
+
+public:
+    ParticleSystem(int max = MAX_PARTICLES) : liveCount(0) {
+        capacity = static_cast<size_t>(std::max(0, std::min(max, PARTICLE_CAPACITY_LIMIT)));
+        posX.resize(capacity); posY.resize(capacity);
+        velX.resize(capacity); velY.resize(capacity);
+        lifetime.resize(capacity);
+        invMaxLifetime.resize(capacity);
+        sizes.resize(capacity);
+        rotation.resize(capacity);
+        rotationSpeed.resize(capacity);
+        colors.resize(capacity);
+    }
+
+    void emit(const Vector2& pos, const Vector2& baseVel, const sf::Color& color, int count, float life, float size = 3.0f) {
+        RandomStream& rng = RandomGenerator::particles();
+        size_t first = liveCount;
+        for (int i = 0; i < count && liveCount < capacity; i++) {
+            Vector2 vel = baseVel + Vector2(rng.range(-80.0f, 80.0f), rng.range(-80.0f, 80.0f));
+            spawn(pos, vel, color, life + rng.range(-0.2f, 0.2f), size);
+        }
+        rng.fill(rotationSpeed.data() + first, liveCount - first, -180.0f, 180.0f);
+    }
+
+    void emitExplosion(const Vector2& pos, int count, float size) {
+        RandomStream& rng = RandomGenerator::particles();
+        size_t first = liveCount;
+        for (int i = 0; i < count && liveCount < capacity; i++) {
+            float angle = rng.range(0.0f, 360.0f) * PI / 180.0f;
+            float speed = rng.range(50.0f, 200.0f);
+            Vector2 vel(cos(angle) * speed, sin(angle) * speed);
+            sf::Color col;
+            int colorType = rng.range(0, 3);
+            if (colorType == 0) col = sf::Color(255, 200, 50);
+            else if (colorType == 1) col = sf::Color(255, 100, 0);
+            else col = sf::Color(255, 50, 0);
+            spawn(pos, vel, col, rng.range(0.5f, 1.2f), size);
+        }
+        rng.fill(rotationSpeed.data() + first, liveCount - first, -180.0f, 180.0f);
+    }
+
+    void update(float dt) {
+        float* __restrict px = posX.data();
+        float* __restrict py = posY.data();
+        float* __restrict vx = velX.data();
+        float* __restrict vy = velY.data();
+        float* __restrict life = lifetime.data();
+        float* __restrict rot = rotation.data();
+        const float* __restrict rotSpeed = rotationSpeed.data();
+        const size_t n = liveCount;
+        // Drag is tuned per 60 Hz frame; scale it so any step size decays the same
+        const float damping = pow(PARTICLE_DRAG, dt * TARGET_FPS);
+        size_t i = 0;
+        bool anyDead = false;
+#ifdef PARTICLES_USE_SSE
+        // Four particles per step; identical results to the scalar tail below
+        const __m128 vdt = _mm_set1_ps(dt);
+        const __m128 drag = _mm_set1_ps(damping);
+        __m128 dead = _mm_setzero_ps();
+        for (; i + 4 <= n; i += 4) {
+            __m128 velXi = _mm_loadu_ps(vx + i);
+            __m128 velYi = _mm_loadu_ps(vy + i);
+            _mm_storeu_ps(px + i, _mm_add_ps(_mm_loadu_ps(px + i), _mm_mul_ps(velXi, vdt)));
+            _mm_storeu_ps(py + i, _mm_add_ps(_mm_loadu_ps(py + i), _mm_mul_ps(velYi, vdt)));
+            _mm_storeu_ps(vx + i, _mm_mul_ps(velXi, drag));
+            _mm_storeu_ps(vy + i, _mm_mul_ps(velYi, drag));
+            __m128 lifeI = _mm_sub_ps(_mm_loadu_ps(life + i), vdt);
+            _mm_storeu_ps(life + i, lifeI);
+            dead = _mm_or_ps(dead, _mm_cmple_ps(lifeI, _mm_setzero_ps()));
+            _mm_storeu_ps(rot + i, _mm_add_ps(_mm_loadu_ps(rot + i), _mm_mul_ps(_mm_loadu_ps(rotSpeed + i), vdt)));
+        }
+        anyDead = _mm_movemask_ps(dead) != 0;
+#endif
+        for (; i < n; i++) {
+            px[i] += vx[i] * dt;
+            py[i] += vy[i] * dt;
+            vx[i] *= damping;
+            vy[i] *= damping;
+            life[i] -= dt;
+            rot[i] += rotSpeed[i] * dt;
+            anyDead |= life[i] <= 0;
+        }
+        if (!anyDead) return;
+
+        // Stable compaction of dead particles; nothing moves until the first death
+        size_t alive = 0;
+        while (alive < n && life[alive] > 0) alive++;
+        for (i = alive + 1; i < n; i++) {
+            if (life[i] > 0) copyParticle(i, alive++);
+        }
+        liveCount = alive;
+    }
+
+    void addTo(PointSpriteBatch& target) const {
+        // Discs look the same at any rotation, so rotation is not needed here
+        for (size_t i = 0; i < liveCount; i++) {
+            // Fade out over the particle's lifetime
+            sf::Color col = colors[i];
+            col.a = static_cast<sf::Uint8>(max(0.0f, lifetime[i] * invMaxLifetime[i] * 255.0f));
+            target.add(posX[i], posY[i], sizes[i], col);
+        }
+    }
+
+    void draw(sf::RenderTarget& window) {
+        batch.clear();
+        addTo(batch);
+        batch.draw(window);
+    }
+
+    void clear() { liveCount = 0; }
+    size_t getCount() const { return liveCount; }
+    size_t getCapacity() const { return capacity; }
+};
+
+// ============================================================================
+// STARFIELD BACKGROUND
+// ============================================================================
+
+class Starfield {
+private:
+    struct Star {
+        float x, y, speed, brightness, size;
+    };
+    vector<Star> stars;
+    PointSpriteBatch batch;
+
+public:
+    Starfield(int count = 200) {
+        for (int i = 0; i < count; i++) {
+            Star s;
+            s.x = RandomGenerator::cosmetic().range(0.0f, SCREEN_WIDTH);
+            s.y = RandomGenerator::cosmetic().range(0.0f, SCREEN_HEIGHT);
+            s.speed = RandomGenerator::cosmetic().range(20.0f, 100.0f);
+            s.brightness = RandomGenerator::cosmetic().range(100.0f, 255.0f);
+            s.size = RandomGenerator::cosmetic().range(1.0f, 2.5f);
+            stars.push_back(s);
+        }
+    }
+
+    void update(float dt) {
+        for (auto& s : stars) {
+            s.y += s.speed * dt;
+            if (s.y > SCREEN_HEIGHT) {
+                s.y = -5;
+                s.x = RandomGenerator::cosmetic().range(0.0f, SCREEN_WIDTH);
+            }
+        }
+    }
+
+    void addTo(PointSpriteBatch& target) const {
+        // Each star's (x, y) is the top-left of its circle's bounding box
+        for (auto& s : stars) {
+            target.add(s.x + s.size, s.y + s.size, s.size, sf::Color(255, 255, 255, static_cast<sf::Uint8>(s.brightness)));
+        }
+    }
+
+    void draw(sf::RenderTarget& window) {
+        batch.clear();
+        addTo(batch);
+        batch.draw(window);
+    }
+};
+
+// ============================================================================
+// ENUMS
+// ============================================================================
+
+enum class GameScreen { Intro, Menu, Instructions, Gameplay, Pause, HighScore, GameOver, Victory, BossWarning };
+
+const char* screenName(GameScreen screen) {
+    switch (screen) {
+    case GameScreen::Intro: return "Intro";
+    case GameScreen::Menu: return "Menu";
+    case GameScreen::Instructions: return "Instructions";
+    case GameScreen::Gameplay: return "Gameplay";
+    case GameScreen::Pause: return "Pause";
+    case GameScreen::HighScore: return "HighScore";
+    case GameScreen::GameOver: return "GameOver";
+    case GameScreen::Victory: return "Victory";
+    case GameScreen::BossWarning: return "BossWarning";
+    }
+    return "?";
+}
+enum class EnemyType { Alpha, Beta, Gamma, Monster, Phantom, Dragon };
+enum class PowerUpType { Power, Fire, Shield, Lives, Nuke, MultiShot, Slow, Danger };
+
+// ============================================================================
+// RENDER SNAPSHOT - Everything drawGameplay needs from one simulation step
+// ============================================================================
+//
+// The simulation copies what the gameplay screen shows into a RenderSnapshot
+// and publishes it through a SnapshotBuffer; the renderer draws the newest
+// one without touching live game objects, so the two can run on different
+// threads. Sprites are stored by texture ID and frame rectangle, plus the
+// offset back to where their owner was one tick earlier for interpolation.
+
+struct SpriteInstance {
+    TextureId texture;
+    sf::IntRect rect;
+    sf::Vector2f position;
+    sf::Vector2f origin;
+    sf::Vector2f scale;
+    float rotation;
+    sf::Color color;
+    sf::Vector2f lag;  // owner's previous position minus its current one
+};
+
+// Copies a sprite into a layer; sprites without a texture ID are skipped. Ones
+// whose texture never loaded are skipped when drawn, so headless runs still
+// build the full draw list.
+bool captureSprite(vector<SpriteInstance>& layer, const sf::Sprite& sprite, TextureId id, const Vector2& lag) {
+    if (id == TextureId::Count) return false;
+    layer.push_back({ id, sprite.getTextureRect(), sprite.getPosition(), sprite.getOrigin(), sprite.getScale(),
+        sprite.getRotation(), sprite.getColor(), sf::Vector2f(lag.x, lag.y) });
+    return true;
+}
+
+struct HealthBarInstance {
+    float x, y;  // top-left corner
+    float width;
+    float fraction;
+    sf::Vector2f lag;
+};
+
+struct HudValues {
+    // Player
+    float health = 0, maxHealth = 1;
+    float shield = 0, maxShield = 1;
+    bool hasShield = false;
+    int lives = 0, score = 0, combo = 0;
+    int powerLevel = 0, multiShotLevel = 0;
+
+    // Level
+    int level = 0, phase = 0;
+    size_t enemyCount = 0;
+    float slowTimeLeft = 0;
+    bool bossLevel = false;
+
+    // Boss
+    bool bossPresent = false;
+    float bossHealthFraction = 0;
+    int bossPhase = 1;
+    bool bossEnraged = false;
+};
+
+struct EntityCounts {
+    size_t enemies = 0;
+    size_t bullets = 0;
+    size_t powerUps = 0;
+    size_t explosions = 0;
+    size_t particles = 0;
+};
+
+// Where gameplay ticks spent their time, in milliseconds
+struct TickTimings {
+    double player = 0;
+    double enemies = 0;     // movement, AI and firing
+    double boss = 0;
+    double bullets = 0;
+    double other = 0;       // power-ups, explosions, spawning
+    double particles = 0;   // particle systems and the starfield
+    double collision = 0;
+    double cleanup = 0;     // removeInactiveObjects()
+
+    double update() const { return player + enemies + boss + bullets + other; }
+
+    TickTimings& operator+=(const TickTimings& t) {
+        player += t.player;
+        enemies += t.enemies;
+        boss += t.boss;
+        bullets += t.bullets;
+        other += t.other;
+        particles += t.particles;
+        collision += t.collision;
+        cleanup += t.cleanup;
+        return *this;
+    }
+};
+
+struct RenderSnapshot {
+    uint64_t tick = 0;                   // simulation ticks run before the capture
+    float alpha = 1.0f;                  // part of a tick left in the accumulator
+    float tickSeconds = 1.0f / SIMULATION_TICK_RATE;  // real time per tick (slow time stretches it)
+    chrono::steady_clock::time_point capturedAt = chrono::steady_clock::now();
+
+    PointSpriteBatch stars;
+    PointSpriteBatch particles;
+    PointSpriteBatch thrust;
+    vector<SpriteInstance> powerUps;
+    vector<SpriteInstance> bullets;
+    vector<SpriteInstance> enemies;
+    vector<HealthBarInstance> healthBars;
+    vector<SpriteInstance> boss;
+    vector<SpriteInstance> explosions;
+    vector<SpriteInstance> player;
+
+    bool bossShield = false;
+    sf::Vector2f bossShieldCenter;
+    sf::Vector2f bossShieldLag;
+    float bossShieldRadius = 0;
+
+    HudValues hud;
+
+    // For the performance overlay: the ticks since the previous snapshot
+    TickTimings timings;
+    EntityCounts counts;
+
+    // Keeps the capacity, so steady-state captures do not allocate
+    void clear() {
+        stars.clear();
+        particles.clear();
+        thrust.clear();
+        powerUps.clear();
+        bullets.clear();
+        enemies.clear();
+        healthBars.clear();
+        boss.clear();
+        explosions.clear();
+        player.clear();
+        bossShield = false;
+    }
+
+    // How far past the captured tick the simulation is by now, for interpolation
+    float renderAlpha() const {
+        float elapsed = chrono::duration<float>(chrono::steady_clock::now() - capturedAt).count();
+        return min(1.0f, alpha + elapsed / tickSeconds);
+    }
+};
+
+// Lock-free triple buffer. The writer and the reader each own one slot; the
+// third holds the newest published snapshot. publish() and acquire() swap
+// their slot with that one in a single atomic exchange, so neither side ever
+// waits and the reader always gets the most recent complete capture.
+class SnapshotBuffer {
+private:
+    static const uint8_t INDEX_MASK = 3;
+    static const uint8_t FRESH = 4;  // set while the middle slot holds an unread snapshot
+
+    array<RenderSnapshot, 3> slots;
+    atomic<uint8_t> middle;
+    uint8_t writeIndex;   // writer side only
+    uint8_t readIndex;    // reader side only
+    uint64_t publishCount;
+    uint64_t freshReads;
+
+public:
+    SnapshotBuffer() : middle(1), writeIndex(0), readIndex(2), publishCount(0), freshReads(0) {}
+
+    RenderSnapshot& beginWrite() {
+        RenderSnapshot& snapshot = slots[writeIndex];
+        snapshot.clear();
+        return snapshot;
+    }
+
+    void publish() {
+        writeIndex = middle.exchange(writeIndex | FRESH, memory_order_acq_rel) & INDEX_MASK;
+        publishCount++;
+    }
+
+    // Newest published snapshot; the same one again if nothing new arrived
+    const RenderSnapshot& acquire() {
+        if (middle.load(memory_order_acquire) & FRESH) {
+            readIndex = middle.exchange(readIndex, memory_order_acq_rel) & INDEX_MASK;
+            freshReads++;
+        }
+        return slots[readIndex];
+    }
+
+    uint64_t getPublishCount() const { return publishCount; }
+    uint64_t getFreshReadCount() const { return freshReads; }
+};
+
+// ============================================================================
+// GAME OBJECT BASE CLASS
+// ============================================================================
+
+class GameObject {
+protected:
+    Vector2 position;
+    Vector2 previousPosition;  // position before the last simulation tick
+    Vector2 velocity;
+    float rotation;
+    bool active;
+    sf::Sprite sprite;
+    TextureId textureId;  // what sprite shows, for render snapshots
+    float boundingRadius;
+    float health;
+    float maxHealth;
+
+    // Offset from where the object is to where it was one tick ago
+    Vector2 lag() const { return previousPosition - position; }
+
+    void captureHealthBar(vector<HealthBarInstance>& bars, float width, float offsetY) const {
+        if (!active || health >= maxHealth) return;
+        Vector2 l = lag();
+        bars.push_back({ position.x - width / 2, position.y + offsetY, width, health / maxHealth, sf::Vector2f(l.x, l.y) });
+    }
+
+public:
+    GameObject() : position(0, 0), previousPosition(0, 0), velocity(0, 0), rotation(0), active(true),
+        textureId(TextureId::Count), boundingRadius(20), health(100), maxHealth(100) {}
+    virtual ~GameObject() = default;
+
+    virtual void update(float dt) {
+        position = position + velocity * dt;
+        sprite.setPosition(position.x, position.y);
+        sprite.setRotation(rotation);
+    }
+
+    // One fixed simulation step; remembers where the object was so drawing
+    // can interpolate between the last two ticks
+    void tick(float dt) {
+        previousPosition = position;
+        update(dt);
+    }
+
+    // Render snapshots: the sprite goes into its layer, anything else (health
+    // bars) into the overlay list drawn after that layer
+    virtual void capture(vector<SpriteInstance>& layer) const {
+        if (active) captureSprite(layer, sprite, textureId, lag());
+    }
+
+    virtual void captureOverlay(vector<HealthBarInstance>&) const {}
+
+    bool checkCollision(GameObject* other) const {
+        if (!active || !other->isActive()) return false;
+        float radii = boundingRadius + other->getBoundingRadius();
+        return position.distanceSquaredTo(other->getPosition()) < radii * radii;
+    }
+
+    // Accessors
+    bool isActive() const { return active; }
+    void setActive(bool a) { active = a; }
+    Vector2 getPosition() const { return position; }
+    // Placement is a teleport, not movement, so there is nothing to interpolate from
+    void setPosition(const Vector2& p) { position = previousPosition = p; sprite.setPosition(p.x, p.y); }
+    Vector2 getVelocity() const { return velocity; }
+    void setVelocity(const Vector2& v) { velocity = v; }
+    float getRotation() const { return rotation; }
+    void setRotation(float r) { rotation = r; sprite.setRotation(r); }
+    float getBoundingRadius() const { return boundingRadius; }
+    void setBoundingRadius(float r) { boundingRadius = r; }
+    float getHealth() const { return health; }
+    float getMaxHealth() const { return maxHealth; }
+    void setHealth(float h) { health = h; }
+    void setMaxHealth(float h) { maxHealth = h; }
+
+    // The collision radius comes from the image size, which headless runs
+    // know from the image headers even though nothing is loaded
+    void setupSprite(TextureId id, float scale = 1.0f) {
+        textureId = id;
+        TextureManager& tm = TextureManager::getInstance();
+        tm.setupSprite(sprite, id, scale);
+        sf::Vector2u size;
+        if (tm.getTextureSize(id, size)) {
+            boundingRadius = (size.x * scale) / 2.5f;
+        }
+    }
+};
+
+// ============================================================================
+// BULLET CLASS
+// ============================================================================
+
+class Bullet : public GameObject {
+private:
+    bool fromPlayer;
+    int damage;
+    bool isBossBullet;
+    const sf::Sprite* style;  // shared per-texture sprite owned by the BulletPool
+
+public:
+    Bullet(bool playerBullet, int dmg = 10, bool bossBullet = false, const sf::Sprite* sharedStyle = nullptr)
+        : fromPlayer(playerBullet), damage(dmg), isBossBullet(bossBullet), style(sharedStyle) {
+        boundingRadius = 8.0f;
+        textureId = bossBullet ? TextureId::BossBullet : (playerBullet ? TextureId::PlayerBullet : TextureId::EnemyBullet);
+    }
+
+    void update(float dt) override {
+        position = position + velocity * dt;
+        if (position.x < -50 || position.x > SCREEN_WIDTH + 50 ||
+            position.y < -50 || position.y > SCREEN_HEIGHT + 50) {
+            active = false;
+        }
+    }
+
+    // The shared style has the scale and origin; position and rotation are the bullet's own
+    void capture(vector<SpriteInstance>& layer) const override {
+        if (!active || !style || !captureSprite(layer, *style, textureId, lag())) return;
+        layer.back().position = sf::Vector2f(position.x, position.y);
+        layer.back().rotation = rotation;
+    }
+
+    bool isFromPlayer() const { return fromPlayer; }
+    int getDamage() const { return damage; }
+    bool isBoss() const { return isBossBullet; }
+};
+
+// ============================================================================
+// BULLET POOL - Fixed-capacity contiguous bullet storage
+// ============================================================================
+
+class BulletPool {
+private:
+    vector<Bullet> bullets;  // reserved once; never grows past capacity
+    size_t capacity;
+    size_t highWaterMark;
+    sf::Sprite playerStyle;
+    sf::Sprite enemyStyle;
+    sf::Sprite bossStyle;
+
+public:
+    explicit BulletPool(size_t cap = MAX_BULLETS) : capacity(cap), highWaterMark(0) {
+        bullets.reserve(capacity);
+    }
+
+    // Bullets point at the style sprites above, so the pool stays put
+    BulletPool(const BulletPool&) = delete;
+    BulletPool& operator=(const BulletPool&) = delete;
+
+    // Resolve the three bullet textures once, after TextureManager has loaded
+    void setupStyles() {
+        TextureManager& tm = TextureManager::getInstance();
+        tm.setupSprite(playerStyle, TextureId::PlayerBullet, 0.9f);
+        tm.setupSprite(enemyStyle, TextureId::EnemyBullet, 0.7f);
+        tm.setupSprite(bossStyle, TextureId::BossBullet, 1.2f);
+    }
+
+    // Returns nullptr when the pool is full; the pointer is valid until the next removeInactive()
+    Bullet* acquire(bool playerBullet, int dmg = 10, bool bossBullet = false) {
+        if (bullets.size() >= capacity) return nullptr;
+        const sf::Sprite* style = bossBullet ? &bossStyle : (playerBullet ? &playerStyle : &enemyStyle);
+        bullets.emplace_back(playerBullet, dmg, bossBullet, style);
+        highWaterMark = max(highWaterMark, bullets.size());
+        return &bullets.back();
+    }
+
+    // Stable in-place compaction, so collision order matches spawn order
+    void removeInactive() {
+        bullets.erase(remove_if(bullets.begin(), bullets.end(),
+            [](const Bullet& b) { return !b.isActive(); }), bullets.end());
+    }
+
+    void clear() { bullets.clear(); }
+
+    Bullet& operator[](size_t index) { return bullets[index]; }
+    vector<Bullet>::iterator begin() { return bullets.begin(); }
+    vector<Bullet>::iterator end() { return bullets.end(); }
+    vector<Bullet>::const_iterator begin() const { return bullets.begin(); }
+    vector<Bullet>::const_iterator end() const { return bullets.end(); }
+    size_t size() const { return bullets.size(); }
+    size_t getCapacity() const { return capacity; }
+    size_t getHighWaterMark() const { return highWaterMark; }
+};
+
+// The same fixed-capacity storage for entities without shared styles
+// (power-ups, explosions), so spawning one doesn't allocate
+template <typename Entity>
+class EntityPool {
+private:
+    vector<Entity> entities;  // reserved once; never grows past capacity
+    size_t capacity;
+
+public:
+    explicit EntityPool(size_t cap) : capacity(cap) {
+        entities.reserve(capacity);
+    }
+
+    // Returns nullptr when the pool is full; the pointer is valid until the next removeInactive()
+    template <typename... Args>
+    Entity* acquire(Args&&... args) {
+        if (entities.size() >= capacity) return nullptr;
+        entities.emplace_back(forward<Args>(args)...);
+        return &entities.back();
+    }
+
+    // Stable in-place compaction, so collision order matches spawn order
+    void removeInactive() {
+        entities.erase(remove_if(entities.begin(), entities.end(),
+            [](const Entity& e) { return !e.isActive(); }), entities.end());
+    }
+
+    void clear() { entities.clear(); }
+
+    typename vector<Entity>::iterator begin() { return entities.begin(); }
+    typename vector<Entity>::iterator end() { return entities.end(); }
+    typename vector<Entity>::const_iterator begin() const { return entities.begin(); }
+    typename vector<Entity>::const_iterator end() const { return entities.end(); }
+    size_t size() const { return entities.size(); }
+};
+
+// Fixed blocks for entities that stay polymorphic behind unique_ptr (enemies,
+// the boss): their class operator new takes a block from here instead of the
+// heap. Used only from the thread that owns the game state; once every block
+// is taken it falls back to the heap.
+template <size_t BlockSize, size_t BlockCount>
+class BlockArena {
+private:
+    union Block {
+        Block* next;
+        alignas(max_align_t) unsigned char bytes[BlockSize];
+    };
+
+    array<Block, BlockCount> blocks;
+    Block* freeList;
+
+    bool owns(const Block* block) const {
+        less<const Block*> before;
+        return !before(block, blocks.data()) && before(block, blocks.data() + BlockCount);
+    }
+
+public:
+    BlockArena() : freeList(nullptr) {
+        for (size_t i = BlockCount; i-- > 0;) {
+            blocks[i].next = freeList;
+            freeList = &blocks[i];
+        }
+    }
+
+    BlockArena(const BlockArena&) = delete;
+    BlockArena& operator=(const BlockArena&) = delete;
+
+    void* allocate(size_t size) {
+        if (size > BlockSize || !freeList) return ::operator new(size);
+        Block* block = freeList;
+        freeList = block->next;
+        return block;
+    }
+
+    void deallocate(void* p) {
+        Block* block = static_cast<Block*>(p);
+        if (!owns(block)) {
+            ::operator delete(p);
+            return;
+        }
+        block->next = freeList;
+        freeList = block;
+    }
+};
+
+// ============================================================================
+// PLAYER SPACESHIP CLASS
+// ============================================================================
+
+class Spaceship : public GameObject {
+private:
+    float shield;
+    float maxShield;
+    float fireRate;
+    float fireTimer;
+    float invincibilityTimer;
+    bool isInvincible;
+    int lives;
+    int score;
+    int combo;
+    float comboTimer;
+    int powerLevel;
+    int multiShotLevel;
+    bool hasShield;
+    ParticleSystem thrustParticles;
+    sf::Sprite shieldSprite;
+
+public:
+    Spaceship() : shield(0), maxShield(PLAYER_MAX_SHIELD), fireRate(BASE_FIRE_RATE), fireTimer(0),
+        invincibilityTimer(0), isInvincible(false), lives(3), score(0), combo(0),
+        comboTimer(0), powerLevel(1), multiShotLevel(1), hasShield(false),
+        thrustParticles(MAX_THRUST_PARTICLES) {
+
+        setupSprite(TextureId::Spaceship, 1.2f);
+        health = PLAYER_MAX_HEALTH;
+        maxHealth = PLAYER_MAX_HEALTH;
+
+        TextureManager::getInstance().setupSprite(shieldSprite, TextureId::ShieldEffect, 1.2f);
+    }
+
+    void update(float dt) override {
+        GameObject::update(dt);
+
+        // Clamp position to screen
+        position.x = max(30.0f, min(SCREEN_WIDTH - 30.0f, position.x));
+        position.y = max(30.0f, min(SCREEN_HEIGHT - 30.0f, position.y));
+
+        fireTimer -= dt;
+
+        if (isInvincible) {
+            invincibilityTimer -= dt;
+            if (invincibilityTimer <= 0) isInvincible = false;
+        }
+
+        // Combo timer
+        if (combo > 0) {
+            comboTimer -= dt;
+            if (comboTimer <= 0) combo = 0;
+        }
+
+        // Thrust particles
+        if (velocity.length() > 30.0f) {
+            thrustParticles.emit(position + Vector2(0, 25), Vector2(0, 50),
+                sf::Color(100, 150, 255, 200), 1, 0.3f, 2.0f);
+        }
+        thrustParticles.update(dt);
+
+        sprite.setPosition(position.x, position.y);
+        shieldSprite.setPosition(position.x, position.y);
+    }
+
+    void capture(vector<SpriteInstance>& layer) const override {
+        size_t first = layer.size();
+        GameObject::capture(layer);
+        if (isInvincible && layer.size() > first) {
+            float alpha = 150 + sin(invincibilityTimer * 15) * 100;
+            layer.back().color = sf::Color(255, 255, 255, static_cast<sf::Uint8>(alpha));
+        }
+
+        if (hasShield && shield > 0 && captureSprite(layer, shieldSprite, TextureId::ShieldEffect, lag())) {
+            float shieldAlpha = (shield / maxShield) * 180.0f;
+            layer.back().color = sf::Color(100, 200, 255, static_cast<sf::Uint8>(shieldAlpha));
+        }
+    }
+
+    void captureThrust(PointSpriteBatch& batch) const { thrustParticles.addTo(batch); }
+    size_t getThrustParticleCount() const { return thrustParticles.getCount(); }
+
+    void captureHud(HudValues& hud) const {
+        hud.health = health;
+        hud.maxHealth = maxHealth;
+        hud.shield = shield;
+        hud.maxShield = maxShield;
+        hud.hasShield = hasShield;
+        hud.lives = lives;
+        hud.score = score;
+        hud.combo = combo;
+        hud.powerLevel = powerLevel;
+        hud.multiShotLevel = multiShotLevel;
+    }
+
+    bool canFire() const { return fireTimer <= 0; }
+    void resetFireTimer() { fireTimer = fireRate; }
+
+    void takeDamage(float dmg) {
+        if (isInvincible) return;
+
+        if (hasShield && shield > 0) {
+            shield -= dmg;
+            if (shield <= 0) {
+                shield = 0;
+                hasShield = false;
+            }
+            return;
+        }
+
+        health -= dmg;
+        SoundManager::getInstance().playSound(SoundId::PlayerHurt);
+
+        if (health <= 0) {
+            lives--;
+            if (lives > 0) {
+                health = maxHealth;
+                isInvincible = true;
+                invincibilityTimer = 3.0f;
+            }
+        }
+    }
+
+    void addScore(int points) {
+        combo++;
+        comboTimer = 2.0f;
+        int comboMultiplier = min(combo, 10);
+        score += points * comboMultiplier;
+    }
+
+    void applyPowerUp(PowerUpType type) {
+        SoundManager::getInstance().playSound(SoundId::Powerup);
+        switch (type) {
+        case PowerUpType::Power:
+            powerLevel = min(powerLevel + 1, 5);
+            fireRate = max(fireRate - 0.015f, MIN_FIRE_RATE);
+            break;
+        case PowerUpType::Fire:
+            fireRate = max(fireRate - 0.025f, MIN_FIRE_RATE);
+            break;
+        case PowerUpType::Shield:
+            hasShield = true;
+            shield = maxShield;
+            break;
+        case PowerUpType::Lives:
+            lives++;
+            health = min(health + 30.0f, maxHealth);
+            break;
+        case PowerUpType::MultiShot:
+            multiShotLevel = min(multiShotLevel + 1, 5);
+            break;
+        case PowerUpType::Danger:
+            isInvincible = true;
+            invincibilityTimer = 5.0f;
+            break;
+        default:
+            break;
+        }
+    }
+
+    void reset() {
+        health = maxHealth;
+        shield = 0;
         hasShield = false;
         fireRate = BASE_FIRE_RATE;
         lives = 3;
@@ -834,568 +3478,1576 @@ public:
         powerLevel = 1;
         multiShotLevel = 1;
         isInvincible = false;
-        position = Vector2(SCREEN_WIDTH / 2, SCREEN_HEIGHT - 100);
+        invincibilityTimer = 0;
+        fireTimer = 0;
+        comboTimer = 0;
+        setPosition(Vector2(SCREEN_WIDTH / 2, SCREEN_HEIGHT - 100));
         velocity = Vector2(0, 0);
         active = true;
         thrustParticles.clear();
     }
 
-    int getLives() const { return lives; }
-    int getScore() const { return score; }
-    int getPowerLevel() const { return powerLevel; }
-    int getMultiShotLevel() const { return multiShotLevel; }
-    bool getIsInvincible() const { return isInvincible; }
-    float getFireRate() const { return fireRate; }
+    int getLives() const { return lives; }
+    int getScore() const { return score; }
+    int getPowerLevel() const { return powerLevel; }
+    int getMultiShotLevel() const { return multiShotLevel; }
+    bool getIsInvincible() const { return isInvincible; }
+    float getFireRate() const { return fireRate; }
+};
+
+// ============================================================================
+// ENEMY BASE CLASS
+// ============================================================================
+
+class Enemy : public GameObject {
+protected:
+    EnemyType type;
+    int scoreValue;
+    float fireRate;
+    float fireTimer;
+    int level;
+    int phase;
+    Vector2 playerPos;
+
+public:
+    Enemy(EnemyType t, int lvl, int ph) : type(t), scoreValue(100), fireRate(2.0f), fireTimer(0), level(lvl), phase(ph) {
+        fireTimer = RandomGenerator::gameplay().range(1.0f, 3.0f);
+    }
+
+    virtual void update(float dt) override {
+        GameObject::update(dt);
+        fireTimer -= dt;
+
+        // Remove if off screen
+        if (position.y > SCREEN_HEIGHT + 100) active = false;
+    }
+
+    void captureOverlay(vector<HealthBarInstance>& bars) const override {
+        captureHealthBar(bars, 35.0f, -boundingRadius - 10);
+    }
+
+    void takeDamage(float dmg) {
+        health -= dmg;
+        if (health <= 0) active = false;
+    }
+
+    bool canFire() const { return fireTimer <= 0 && position.y > 50 && position.y < SCREEN_HEIGHT - 100; }
+    void resetFireTimer() { fireTimer = fireRate + RandomGenerator::gameplay().range(-0.5f, 0.5f); }
+    void setPlayerPosition(const Vector2& pos) { playerPos = pos; }
+    int getScoreValue() const { return scoreValue; }
+    EnemyType getType() const { return type; }
+
+    // Every enemy type comes out of one arena, so a wave spawns without
+    // touching the heap
+    static BlockArena<ENEMY_BLOCK_SIZE, ENEMY_RESERVE>& arena() {
+        static BlockArena<ENEMY_BLOCK_SIZE, ENEMY_RESERVE> blocks;
+        return blocks;
+    }
+
+    static void* operator new(size_t size) { return arena().allocate(size); }
+    static void operator delete(void* p) { arena().deallocate(p); }
+};
+
+// ============================================================================
+// SPECIFIC ENEMY TYPES
+// ============================================================================
+
+// Alpha Enemy - Basic, moves straight down
+class AlphaEnemy : public Enemy {
+public:
+    AlphaEnemy(int level, int phase) : Enemy(EnemyType::Alpha, level, phase) {
+        setupSprite(TextureId::EnemyAlpha, 1.2f);
+        health = 30 + level * 10;
+        maxHealth = health;
+        scoreValue = 100 + level * 20;
+        velocity = Vector2(RandomGenerator::gameplay().range(-30.0f, 30.0f), RandomGenerator::gameplay().range(80.0f, 120.0f));
+        fireRate = 2.5f;
+    }
+};
+
+// Beta Enemy - Weaves side to side
+class BetaEnemy : public Enemy {
+private:
+    float waveTimer;
+    float waveAmplitude;
+
+public:
+    BetaEnemy(int level, int phase) : Enemy(EnemyType::Beta, level, phase), waveTimer(0) {
+        setupSprite(TextureId::EnemyBeta, 1.0f);
+        health = 45 + level * 15;
+        maxHealth = health;
+        scoreValue = 150 + level * 30;
+        velocity = Vector2(0, RandomGenerator::gameplay().range(60.0f, 100.0f));
+        waveAmplitude = RandomGenerator::gameplay().range(80.0f, 150.0f);
+        fireRate = 2.0f;
+    }
+
+    void update(float dt) override {
+        waveTimer += dt * 3.0f;
+        position.x += sin(waveTimer) * waveAmplitude * dt;
+        Enemy::update(dt);
+    }
+};
+
+// Gamma Enemy - Follows player horizontally
+class GammaEnemy : public Enemy {
+private:
+    float seekSpeed;
+
+public:
+    GammaEnemy(int level, int phase) : Enemy(EnemyType::Gamma, level, phase) {
+        setupSprite(TextureId::EnemyGamma, 0.9f);
+        health = 60 + level * 20;
+        maxHealth = health;
+        scoreValue = 200 + level * 40;
+        velocity = Vector2(0, RandomGenerator::gameplay().range(40.0f, 70.0f));
+        seekSpeed = 100.0f + level * 20.0f;
+        fireRate = 1.8f;
+    }
+
+    void update(float dt) override {
+        // Move towards player horizontally
+        if (playerPos.x > position.x + 20) velocity.x = seekSpeed;
+        else if (playerPos.x < position.x - 20) velocity.x = -seekSpeed;
+        else velocity.x = 0;
+        Enemy::update(dt);
+    }
+};
+
+// Monster Enemy - Charges at player
+class MonsterEnemy : public Enemy {
+private:
+    float chargeTimer;
+    bool isCharging;
+
+public:
+    MonsterEnemy(int level, int phase) : Enemy(EnemyType::Monster, level, phase), chargeTimer(3.0f), isCharging(false) {
+        setupSprite(TextureId::EnemyMonster, 0.95f);
+        health = 80 + level * 25;
+        maxHealth = health;
+        scoreValue = 300 + level * 50;
+        velocity = Vector2(RandomGenerator::gameplay().range(-20.0f, 20.0f), 50.0f);
+        fireRate = 1.5f;
+    }
+
+    void update(float dt) override {
+        chargeTimer -= dt;
+
+        if (!isCharging && chargeTimer <= 0) {
+            Vector2 dir = (playerPos - position).normalized();
+            velocity = dir * 300.0f;
+            isCharging = true;
+            chargeTimer = 1.5f;
+        }
+        else if (isCharging && chargeTimer <= 0) {
+            velocity = Vector2(RandomGenerator::gameplay().range(-20.0f, 20.0f), 50.0f);
+            isCharging = false;
+            chargeTimer = RandomGenerator::gameplay().range(2.0f, 4.0f);
+        }
+
+        Enemy::update(dt);
+    }
+};
+
+// Phantom Enemy - Fades in and out
+class PhantomEnemy : public Enemy {
+private:
+    float fadeTimer;
+    bool isVisible;
+
+public:
+    PhantomEnemy(int level, int phase) : Enemy(EnemyType::Phantom, level, phase), fadeTimer(2.0f), isVisible(true) {
+        setupSprite(TextureId::EnemyPhantom, 0.8f);
+        health = 50 + level * 15;
+        maxHealth = health;
+        scoreValue = 250 + level * 45;
+        velocity = Vector2(RandomGenerator::gameplay().range(-50.0f, 50.0f), RandomGenerator::gameplay().range(70.0f, 100.0f));
+        fireRate = 1.3f;
+    }
+
+    void update(float dt) override {
+        fadeTimer -= dt;
+        if (fadeTimer <= 0) {
+            isVisible = !isVisible;
+            fadeTimer = 2.0f;
+        }
+
+        sf::Uint8 alpha = isVisible ? 255 : 80;
+        sprite.setColor(sf::Color(255, 255, 255, alpha));
+
+        Enemy::update(dt);
+    }
+};
+
+// Dragon Enemy - Mini-boss, complex movement
+class DragonEnemy : public Enemy {
+private:
+    float stateTimer;
+    int state;
+    float angleOffset;
+
+public:
+    DragonEnemy(int level, int phase) : Enemy(EnemyType::Dragon, level, phase), stateTimer(3.0f), state(0), angleOffset(0) {
+        setupSprite(TextureId::EnemyDragon, 1.0f);
+        health = 200 + level * 50;
+        maxHealth = health;
+        scoreValue = 500 + level * 100;
+        velocity = Vector2(0, 0);
+        fireRate = 0.5f;
+        boundingRadius = 40.0f;
+    }
+
+    void update(float dt) override {
+        stateTimer -= dt;
+        angleOffset += dt;
+
+        // Circle movement
+        position.x = SCREEN_WIDTH / 2 + cos(angleOffset) * 200;
+        position.y = 150 + sin(angleOffset * 0.5f) * 50;
+
+        sprite.setPosition(position.x, position.y);
+        fireTimer -= dt;
+
+        if (health <= 0) active = false;
+    }
+
+    void captureOverlay(vector<HealthBarInstance>& bars) const override {
+        captureHealthBar(bars, 60.0f, -50.0f);
+    }
+};
+
+static_assert(max({ sizeof(AlphaEnemy), sizeof(BetaEnemy), sizeof(GammaEnemy), sizeof(MonsterEnemy),
+    sizeof(PhantomEnemy), sizeof(DragonEnemy) }) <= ENEMY_BLOCK_SIZE, "an enemy type outgrew its arena block");
+
+// ============================================================================
+// FINAL BOSS CLASS
+// ============================================================================
+
+class FinalBoss : public GameObject {
+private:
+    int bossPhase;
+    float phaseTimer;
+    float attackTimer;
+    float moveAngle;
+    Vector2 playerPos;
+    sf::Sprite eyeSprite;
+    int attackPattern;
+    bool isEnraged;
+    float shieldTimer;
+    bool hasShield;
+
+public:
+    FinalBoss() : bossPhase(1), phaseTimer(0), attackTimer(0), moveAngle(0), attackPattern(0), isEnraged(false), shieldTimer(0), hasShield(true) {
+        setupSprite(TextureId::Boss, 1.5f);
+        health = 500.0f;
+        maxHealth = 500.0f;
+        boundingRadius = 80.0f;
+        setPosition(Vector2(SCREEN_WIDTH / 2, -150));
+
+        TextureManager::getInstance().setupSprite(eyeSprite, TextureId::BossEye);
+    }
+
+    void update(float dt) override {
+        // Entry animation
+        if (position.y < 150) {
+            position.y += 50.0f * dt;
+            sprite.setPosition(position.x, position.y);
+            eyeSprite.setPosition(position.x, position.y - 10);
+            return;
+        }
+
+        attackTimer -= dt;
+        moveAngle += dt;
+        phaseTimer += dt;
+        shieldTimer -= dt;
+
+        // Update boss phase based on health
+        float healthPercent = health / maxHealth;
+        if (healthPercent <= 0.3f) {
+            bossPhase = 3;
+            isEnraged = true;
+        }
+        else if (healthPercent <= 0.6f) {
+            bossPhase = 2;
+        }
+
+        // Movement patterns
+        switch (bossPhase) {
+        case 1:
+            position.x = SCREEN_WIDTH / 2 + sin(moveAngle * 0.8f) * 250;
+            position.y = 150 + sin(moveAngle * 0.5f) * 30;
+            break;
+        case 2:
+            position.x = SCREEN_WIDTH / 2 + sin(moveAngle * 1.2f) * 300;
+            position.y = 120 + sin(moveAngle * 0.8f) * 50;
+            break;
+        case 3:
+            position.x = SCREEN_WIDTH / 2 + sin(moveAngle * 1.5f) * 350;
+            position.y = 100 + sin(moveAngle) * 80;
+            break;
+        }
+
+        // Shield regeneration
+        if (shieldTimer <= 0 && !hasShield && bossPhase >= 2) {
+            hasShield = true;
+            shieldTimer = 10.0f;
+        }
+
+        sprite.setPosition(position.x, position.y);
+
+        // Eye follows player
+        Vector2 toPlayer = (playerPos - position).normalized();
+        eyeSprite.setPosition(position.x + toPlayer.x * 15, position.y - 10 + toPlayer.y * 10);
+
+        // Enraged color
+        if (isEnraged) {
+            float pulse = sin(phaseTimer * 8) * 0.3f + 0.7f;
+            sprite.setColor(sf::Color(255, static_cast<sf::Uint8>(100 * pulse), static_cast<sf::Uint8>(100 * pulse)));
+        }
+    }
+
+    // The eye is drawn even while the boss is inactive, as it always was
+    void capture(vector<SpriteInstance>& layer) const override {
+        GameObject::capture(layer);
+        captureSprite(layer, eyeSprite, TextureId::BossEye, lag());
+    }
+
+    void captureShield(RenderSnapshot& snapshot) const {
+        if (!hasShield) return;
+        Vector2 l = lag();
+        snapshot.bossShield = true;
+        snapshot.bossShieldCenter = sf::Vector2f(position.x, position.y);
+        snapshot.bossShieldLag = sf::Vector2f(l.x, l.y);
+        snapshot.bossShieldRadius = boundingRadius + 20;
+    }
+
+    void captureHud(HudValues& hud) const {
+        hud.bossPresent = true;
+        hud.bossHealthFraction = health / maxHealth;
+        hud.bossPhase = bossPhase;
+        hud.bossEnraged = isEnraged;
+    }
+
+    void takeDamage(float dmg) {
+        if (hasShield) {
+            dmg *= 0.3f;
+            shieldTimer -= 2.0f;
+            if (shieldTimer <= 0) hasShield = false;
+        }
+        health -= dmg;
+        SoundManager::getInstance().playSound(SoundId::BossHit);
+        if (health <= 0) active = false;
+    }
+
+    void fireAttackBullets(BulletPool& bullets) {
+        if (attackTimer > 0 || position.y < 150) return;
+
+        float attackDelay;
+        switch (bossPhase) {
+        case 1: attackDelay = 0.8f; break;
+        case 2: attackDelay = 0.5f; break;
+        case 3: attackDelay = 0.3f; break;
+        default: attackDelay = 1.0f;
+        }
+        attackTimer = attackDelay;
+        attackPattern = (attackPattern + 1) % 4;
+
+        // Different attack patterns
+        switch (attackPattern) {
+        case 0: // Spread shot
+        {
+            int bulletCount = 5 + bossPhase * 2;
+            float angleSpread = 60.0f + bossPhase * 20.0f;
+            float startAngle = 90.0f - angleSpread / 2;
+
+            for (int i = 0; i < bulletCount; i++) {
+                float angle = (startAngle + (angleSpread / (bulletCount - 1)) * i) * PI / 180.0f;
+                Bullet* bullet = bullets.acquire(false, 15 + bossPhase * 5, true);
+                if (!bullet) return;
+                bullet->setPosition(position + Vector2(0, 40));
+                bullet->setVelocity(Vector2(cos(angle) * 250, sin(angle) * 250));
+            }
+            break;
+        }
+        case 1: // Aimed shot
+        {
+            Vector2 dir = (playerPos - position).normalized();
+            for (int i = -1; i <= 1; i++) {
+                Bullet* bullet = bullets.acquire(false, 20 + bossPhase * 5, true);
+                if (!bullet) return;
+                bullet->setPosition(position + Vector2(i * 30, 40));
+                bullet->setVelocity(dir * 350.0f);
+            }
+            break;
+        }
+        case 2: // Circular burst
+        {
+            int bulletCount = 8 + bossPhase * 4;
+            for (int i = 0; i < bulletCount; i++) {
+                float angle = (360.0f / bulletCount * i + phaseTimer * 30) * PI / 180.0f;
+                Bullet* bullet = bullets.acquire(false, 10 + bossPhase * 3, true);
+                if (!bullet) return;
+                bullet->setPosition(position);
+                bullet->setVelocity(Vector2(cos(angle) * 200, sin(angle) * 200));
+            }
+            break;
+        }
+        case 3: // Spiral
+        {
+            if (bossPhase >= 2) {
+                for (int i = 0; i < 3; i++) {
+                    float angle = (phaseTimer * 100 + i * 120) * PI / 180.0f;
+                    Bullet* bullet = bullets.acquire(false, 12 + bossPhase * 4, true);
+                    if (!bullet) return;
+                    bullet->setPosition(position);
+                    bullet->setVelocity(Vector2(cos(angle) * 220, sin(angle) * 220));
+                }
+            }
+            break;
+        }
+        }
+    }
+
+    void setPlayerPosition(const Vector2& pos) { playerPos = pos; }
+    void resetAttackTimer() { attackTimer = 0; }
+    int getBossPhase() const { return bossPhase; }
+    bool hasActiveShield() const { return hasShield; }
+
+    // Two blocks: a new boss is made before the one it replaces is freed
+    static BlockArena<BOSS_BLOCK_SIZE, 2>& arena() {
+        static BlockArena<BOSS_BLOCK_SIZE, 2> blocks;
+        return blocks;
+    }
+
+    static void* operator new(size_t size) { return arena().allocate(size); }
+    static void operator delete(void* p) { arena().deallocate(p); }
+};
+
+static_assert(sizeof(FinalBoss) <= BOSS_BLOCK_SIZE, "FinalBoss outgrew its arena block");
+
+// ============================================================================
+// POWER-UP CLASS
+// ============================================================================
+
+class PowerUp : public GameObject {
+private:
+    PowerUpType type;
+    float lifetime;
+    float bobTimer;
+
+public:
+    PowerUp(PowerUpType t) : type(t), lifetime(12.0f), bobTimer(0) {
+        TextureId textureId = TextureId::PowerupPower;
+        switch (type) {
+        case PowerUpType::Power: textureId = TextureId::PowerupPower; break;
+        case PowerUpType::Fire: textureId = TextureId::PowerupFire; break;
+        case PowerUpType::Shield: textureId = TextureId::PowerupShield; break;
+        case PowerUpType::Lives: textureId = TextureId::PowerupLives; break;
+        case PowerUpType::Nuke: textureId = TextureId::PowerupNuke; break;
+        case PowerUpType::MultiShot: textureId = TextureId::PowerupMultishot; break;
+        case PowerUpType::Slow: textureId = TextureId::PowerupSlow; break;
+        case PowerUpType::Danger: textureId = TextureId::PowerupDanger; break;
+        }
+        setupSprite(textureId, 1.0f);
+        velocity = Vector2(RandomGenerator::gameplay().range(-20.0f, 20.0f), RandomGenerator::gameplay().range(40.0f, 80.0f));
+        boundingRadius = 15.0f;
+    }
+
+    void update(float dt) override {
+        GameObject::update(dt);
+        lifetime -= dt;
+        bobTimer += dt;
+        rotation += 90.0f * dt;
+
+        // Bob up and down
+        sprite.setPosition(position.x, position.y + sin(bobTimer * 4) * 5);
+        sprite.setRotation(rotation);
+
+        if (lifetime <= 0 || position.y > SCREEN_HEIGHT + 50) {
+            active = false;
+        }
+
+        // Blink when about to expire
+        if (lifetime < 3.0f) {
+            float alpha = 128 + sin(lifetime * 10) * 127;
+            sprite.setColor(sf::Color(255, 255, 255, static_cast<sf::Uint8>(alpha)));
+        }
+    }
+
+    PowerUpType getType() const { return type; }
+};
+
+// ============================================================================
+// EXPLOSION ANIMATION
+// ============================================================================
+
+class Explosion : public GameObject {
+private:
+    int currentFrame;
+    int totalFrames;
+    float frameTime;
+    float frameTimer;
+    float frameWidth;
+    sf::IntRect sheet;  // the spritesheet's rectangle on its atlas page
+
+public:
+    Explosion(const Vector2& pos, float scale = 1.0f) : currentFrame(0), totalFrames(8), frameTime(0.08f), frameTimer(0), frameWidth(0) {
+        setPosition(pos);
+        textureId = TextureId::Explosion;
+        const TextureRegion* region = TextureManager::getInstance().findRegion(TextureId::Explosion);
+        if (region) {
+            sheet = region->rect;
+            sprite.setTexture(*region->texture);
+            frameWidth = static_cast<float>(sheet.width) / totalFrames;
+            sprite.setTextureRect(sf::IntRect(sheet.left, sheet.top, static_cast<int>(frameWidth), sheet.height));
+            sprite.setOrigin(frameWidth / 2, sheet.height / 2.0f);
+            sprite.setScale(scale, scale);
+            sprite.setPosition(pos.x, pos.y);
+        }
+    }
+
+    void update(float dt) override {
+        frameTimer += dt;
+        if (frameTimer >= frameTime) {
+            frameTimer = 0;
+            currentFrame++;
+            if (currentFrame >= totalFrames) {
+                active = false;
+            }
+            else {
+                sprite.setTextureRect(sf::IntRect(sheet.left + static_cast<int>(currentFrame * frameWidth), sheet.top,
+                    static_cast<int>(frameWidth), sheet.height));
+            }
+        }
+    }
 };
 
 // ============================================================================
-// ENEMY BASE CLASS
+// COLLISION BROADPHASE - Uniform grid rebuilt every frame
 // ============================================================================
 
-class Enemy : public GameObject {
-protected:
-    EnemyType type;
-    int scoreValue;
-    float fireRate;
-    float fireTimer;
-    int level;
-    int phase;
-    Vector2 playerPos;
+// Indexes a set of circles (enemies) so that each probe (a bullet, the player)
+// only visits the few that share its cells instead of the whole set.
+class SpatialGrid {
+private:
+    struct Entry {
+        int index;
+        int minX, minY, maxX, maxY;  // covered cell range (inclusive)
+    };
+
+    float invCellSize;
+    float originX;
+    float originY;
+    int cols;
+    int rows;
+    vector<Entry> entries;
+    vector<int> cellStart;  // offsets into cellItems, one per cell + 1
+    vector<int> cellFill;
+    vector<int> cellItems;  // entry ids bucketed by cell
+
+    int cellCoord(float value, float origin, int count) const {
+        float c = (value - origin) * invCellSize;
+        return static_cast<int>(max(0.0f, min(static_cast<float>(count - 1), c)));
+    }
 
 public:
-    Enemy(EnemyType t, int lvl, int ph) : type(t), scoreValue(100), fireRate(2.0f), fireTimer(0), level(lvl), phase(ph) {
-        fireTimer = RandomGenerator::range(1.0f, 3.0f);
+    // Covers the screen plus a margin; anything further out is clamped into the border cells
+    SpatialGrid(float cellSize = 64.0f, float margin = 64.0f)
+        : invCellSize(1.0f / cellSize), originX(-margin), originY(-margin),
+        cols(static_cast<int>(ceil((SCREEN_WIDTH + margin * 2) / cellSize))),
+        rows(static_cast<int>(ceil((SCREEN_HEIGHT + margin * 2) / cellSize))) {
+        cellStart.assign(cols * rows + 1, 0);
+        cellFill.assign(cols * rows, 0);
     }
 
-    virtual void update(float dt) override {
-        GameObject::update(dt);
-        fireTimer -= dt;
+    void clear() { entries.clear(); }
 
-        // Remove if off screen
-        if (position.y > SCREEN_HEIGHT + 100) active = false;
+    // Room for this many entries, each covering a few cells, before any frame needs it
+    void reserve(size_t entryCount) {
+        entries.reserve(entryCount);
+        cellItems.reserve(entryCount * 9);
     }
 
-    void draw(sf::RenderWindow& window) override {
-        GameObject::draw(window);
-        drawHealthBar(window, 35.0f, -boundingRadius - 10);
+    void insert(int index, const Vector2& pos, float radius) {
+        Entry e;
+        e.index = index;
+        e.minX = cellCoord(pos.x - radius, originX, cols);
+        e.maxX = cellCoord(pos.x + radius, originX, cols);
+        e.minY = cellCoord(pos.y - radius, originY, rows);
+        e.maxY = cellCoord(pos.y + radius, originY, rows);
+        entries.push_back(e);
     }
 
-    void takeDamage(float dmg) {
-        health -= dmg;
-        if (health <= 0) active = false;
+    // Counting sort of entries into cells; a warm grid never allocates
+    void build() {
+        fill(cellStart.begin(), cellStart.end(), 0);
+        for (const auto& e : entries) {
+            for (int y = e.minY; y <= e.maxY; y++)
+                for (int x = e.minX; x <= e.maxX; x++)
+                    cellStart[y * cols + x + 1]++;
+        }
+        for (size_t i = 1; i < cellStart.size(); i++) cellStart[i] += cellStart[i - 1];
+
+        cellItems.resize(cellStart.back());
+        copy(cellStart.begin(), cellStart.end() - 1, cellFill.begin());
+        for (size_t id = 0; id < entries.size(); id++) {
+            const Entry& e = entries[id];
+            for (int y = e.minY; y <= e.maxY; y++)
+                for (int x = e.minX; x <= e.maxX; x++)
+                    cellItems[cellFill[y * cols + x]++] = static_cast<int>(id);
+        }
     }
 
-    bool canFire() const { return fireTimer <= 0 && position.y > 50 && position.y < SCREEN_HEIGHT - 100; }
-    void resetFireTimer() { fireTimer = fireRate + RandomGenerator::range(-0.5f, 0.5f); }
-    void setPlayerPosition(const Vector2& pos) { playerPos = pos; }
-    int getScoreValue() const { return scoreValue; }
-    EnemyType getType() const { return type; }
+    // Candidates whose cell range overlaps the probe circle, sorted ascending.
+    // Each candidate is reported once, from the first cell it shares with the probe.
+    void query(const Vector2& pos, float radius, vector<int>& out) const {
+        out.clear();
+        int minX = cellCoord(pos.x - radius, originX, cols);
+        int maxX = cellCoord(pos.x + radius, originX, cols);
+        int minY = cellCoord(pos.y - radius, originY, rows);
+        int maxY = cellCoord(pos.y + radius, originY, rows);
+        for (int y = minY; y <= maxY; y++) {
+            for (int x = minX; x <= maxX; x++) {
+                int cell = y * cols + x;
+                for (int i = cellStart[cell]; i < cellStart[cell + 1]; i++) {
+                    const Entry& e = entries[cellItems[i]];
+                    if (max(minX, e.minX) != x || max(minY, e.minY) != y) continue;
+                    out.push_back(e.index);
+                }
+            }
+        }
+        if (out.size() > 1) sort(out.begin(), out.end());
+    }
+
+    size_t getEntryCount() const { return entries.size(); }
 };
 
 // ============================================================================
-// SPECIFIC ENEMY TYPES
+// REPLAY - Per-tick input recording and streamed playback
 // ============================================================================
-
-// Alpha Enemy - Basic, moves straight down
-class AlphaEnemy : public Enemy {
-public:
-    AlphaEnemy(int level, int phase) : Enemy(EnemyType::Alpha, level, phase) {
-        setupSprite("enemy_alpha", 1.2f);
-        health = 30 + level * 10;
-        maxHealth = health;
-        scoreValue = 100 + level * 20;
-        velocity = Vector2(RandomGenerator::range(-30.0f, 30.0f), RandomGenerator::range(80.0f, 120.0f));
-        fireRate = 2.5f;
-    }
+//
+// A recording holds everything the simulation takes from the player: each
+// game's seed and difficulty, then one input byte per tick. Replaying it runs
+// the same ticks with the same input, so the outcome matches tick for tick.
+// Layout (little-endian): ReplayHeader, then tagged records:
+//   REPLAY_GAME   seed (u64), difficulty (f32)   a startGame() with these
+//   REPLAY_INPUT  changed bits (u8), ticks       input XOR the previous input,
+//                                                then held for ticks (varint)
+//   REPLAY_CHECK  checksum (u32)                 state after the ticks so far
+//   REPLAY_END
+// Input changes a few times a second at most, so an hour is tens of KB.
+
+// Controls held during a simulation tick
+struct PlayerInput {
+    bool up = false;
+    bool down = false;
+    bool left = false;
+    bool right = false;
+    bool fire = false;
 };
 
-// Beta Enemy - Weaves side to side
-class BetaEnemy : public Enemy {
-private:
-    float waveTimer;
-    float waveAmplitude;
+const uint32_t REPLAY_VERSION = 1;
+const uint64_t REPLAY_CHECK_INTERVAL = 600;   // ticks between state checksums
 
-public:
-    BetaEnemy(int level, int phase) : Enemy(EnemyType::Beta, level, phase), waveTimer(0) {
-        setupSprite("enemy_beta", 1.0f);
-        health = 45 + level * 15;
-        maxHealth = health;
-        scoreValue = 150 + level * 30;
-        velocity = Vector2(0, RandomGenerator::range(60.0f, 100.0f));
-        waveAmplitude = RandomGenerator::range(80.0f, 150.0f);
-        fireRate = 2.0f;
-    }
+enum ReplayRecordType : uint8_t {
+    REPLAY_END = 0,
+    REPLAY_GAME = 1,
+    REPLAY_INPUT = 2,
+    REPLAY_CHECK = 3
+};
 
-    void update(float dt) override {
-        waveTimer += dt * 3.0f;
-        position.x += sin(waveTimer) * waveAmplitude * dt;
-        Enemy::update(dt);
-    }
+// One tick's input byte: the held controls, and whether the game was paused
+enum ReplayInputBits : uint8_t {
+    INPUT_UP = 1 << 0,
+    INPUT_DOWN = 1 << 1,
+    INPUT_LEFT = 1 << 2,
+    INPUT_RIGHT = 1 << 3,
+    INPUT_FIRE = 1 << 4,
+    INPUT_PAUSED = 1 << 5
 };
 
-// Gamma Enemy - Follows player horizontally
-class GammaEnemy : public Enemy {
+struct ReplayHeader {
+    char magic[4];
+    uint32_t version;
+    float tickRate;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(ReplayHeader) == 16, "replay header layout");
+
+uint8_t packInput(const PlayerInput& keys, bool paused) {
+    return (keys.up ? INPUT_UP : 0) | (keys.down ? INPUT_DOWN : 0) | (keys.left ? INPUT_LEFT : 0) |
+        (keys.right ? INPUT_RIGHT : 0) | (keys.fire ? INPUT_FIRE : 0) | (paused ? INPUT_PAUSED : 0);
+}
+
+PlayerInput unpackInput(uint8_t bits) {
+    PlayerInput keys;
+    keys.up = (bits & INPUT_UP) != 0;
+    keys.down = (bits & INPUT_DOWN) != 0;
+    keys.left = (bits & INPUT_LEFT) != 0;
+    keys.right = (bits & INPUT_RIGHT) != 0;
+    keys.fire = (bits & INPUT_FIRE) != 0;
+    return keys;
+}
+
+// Encodes on the simulation thread and hands finished chunks to a writer
+// thread, so a slow disk never holds up a tick
+class ReplayWriter {
 private:
-    float seekSpeed;
+    static const size_t CHUNK_BYTES = 4096;
+
+    ofstream file;
+    thread writerThread;
+    mutex queueMutex;
+    condition_variable queueReady;
+    vector<uint8_t> queued;      // encoded, waiting for the writer thread
+    bool closing = false;
+
+    // Encoder state (simulation thread only)
+    vector<uint8_t> chunk;
+    uint8_t writtenBits = 0;     // input as of the last REPLAY_INPUT record
+    uint8_t runBits = 0;         // input of the run not yet written
+    uint64_t runTicks = 0;
+    uint64_t ticksSinceCheck = 0;
+
+    uint64_t ticksRecorded = 0;
+    uint64_t gamesRecorded = 0;
+    uint64_t bytesEncoded = 0;
+
+    void putByte(uint8_t value) { chunk.push_back(value); }
+
+    void putBytes(const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        chunk.insert(chunk.end(), bytes, bytes + size);
+    }
 
-public:
-    GammaEnemy(int level, int phase) : Enemy(EnemyType::Gamma, level, phase) {
-        setupSprite("enemy_gamma", 0.9f);
-        health = 60 + level * 20;
-        maxHealth = health;
-        scoreValue = 200 + level * 40;
-        velocity = Vector2(0, RandomGenerator::range(40.0f, 70.0f));
-        seekSpeed = 100.0f + level * 20.0f;
-        fireRate = 1.8f;
+    void putVarint(uint64_t value) {
+        while (value >= 0x80) {
+            chunk.push_back(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        chunk.push_back(static_cast<uint8_t>(value));
     }
 
-    void update(float dt) override {
-        // Move towards player horizontally
-        if (playerPos.x > position.x + 20) velocity.x = seekSpeed;
-        else if (playerPos.x < position.x - 20) velocity.x = -seekSpeed;
-        else velocity.x = 0;
-        Enemy::update(dt);
+    void flushRun() {
+        if (runTicks == 0) return;
+        putByte(REPLAY_INPUT);
+        putByte(runBits ^ writtenBits);
+        putVarint(runTicks);
+        writtenBits = runBits;
+        runTicks = 0;
     }
-};
 
-// Monster Enemy - Charges at player
-class MonsterEnemy : public Enemy {
-private:
-    float chargeTimer;
-    bool isCharging;
+    void handOff(bool force) {
+        if (chunk.empty() || (!force && chunk.size() < CHUNK_BYTES)) return;
+        bytesEncoded += chunk.size();
+        {
+            lock_guard<mutex> lock(queueMutex);
+            queued.insert(queued.end(), chunk.begin(), chunk.end());
+        }
+        chunk.clear();
+        queueReady.notify_one();
+    }
 
-public:
-    MonsterEnemy(int level, int phase) : Enemy(EnemyType::Monster, level, phase), chargeTimer(3.0f), isCharging(false) {
-        setupSprite("enemy_monster", 0.95f);
-        health = 80 + level * 25;
-        maxHealth = health;
-        scoreValue = 300 + level * 50;
-        velocity = Vector2(RandomGenerator::range(-20.0f, 20.0f), 50.0f);
-        fireRate = 1.5f;
+    void writerLoop() {
+        vector<uint8_t> writing;
+        unique_lock<mutex> lock(queueMutex);
+        while (true) {
+            queueReady.wait(lock, [this] { return closing || !queued.empty(); });
+            if (queued.empty()) break;   // closing, and everything is written
+            writing.swap(queued);
+            lock.unlock();
+            file.write(reinterpret_cast<const char*>(writing.data()), writing.size());
+            writing.clear();
+            lock.lock();
+        }
+        file.flush();
     }
 
-    void update(float dt) override {
-        chargeTimer -= dt;
+public:
+    ~ReplayWriter() { close(); }
 
-        if (!isCharging && chargeTimer <= 0) {
-            Vector2 dir = (playerPos - position).normalized();
-            velocity = dir * 300.0f;
-            isCharging = true;
-            chargeTimer = 1.5f;
+    bool open(const string& path, float tickRate) {
+        file.open(path, ios::binary | ios::trunc);
+        if (!file.is_open()) {
+            cerr << "[FAIL] Could not create replay: " << path << endl;
+            return false;
         }
-        else if (isCharging && chargeTimer <= 0) {
-            velocity = Vector2(RandomGenerator::range(-20.0f, 20.0f), 50.0f);
-            isCharging = false;
-            chargeTimer = RandomGenerator::range(2.0f, 4.0f);
+        ReplayHeader header = { { 'S', 'S', 'R', 'P' }, REPLAY_VERSION, tickRate, 0 };
+        putBytes(&header, sizeof(header));
+        writerThread = thread(&ReplayWriter::writerLoop, this);
+        cout << "[OK] Recording replay: " << path << endl;
+        return true;
+    }
+
+    // Everything recorded so far reaches the file before this returns
+    void close() {
+        if (!writerThread.joinable()) return;
+        flushRun();
+        putByte(REPLAY_END);
+        handOff(true);
+        {
+            lock_guard<mutex> lock(queueMutex);
+            closing = true;
         }
+        queueReady.notify_one();
+        writerThread.join();
+        file.close();
+    }
 
-        Enemy::update(dt);
+    void beginGame(uint64_t seed, float difficulty) {
+        flushRun();
+        putByte(REPLAY_GAME);
+        putBytes(&seed, sizeof(seed));
+        putBytes(&difficulty, sizeof(difficulty));
+        writtenBits = 0;   // each game decodes on its own
+        ticksSinceCheck = 0;
+        gamesRecorded++;
+    }
+
+    void recordTick(uint8_t bits) {
+        if (runTicks > 0 && bits != runBits) flushRun();
+        runBits = bits;
+        runTicks++;
+        ticksRecorded++;
+        ticksSinceCheck++;
+        handOff(false);
     }
+
+    bool checkpointDue() const { return ticksSinceCheck >= REPLAY_CHECK_INTERVAL; }
+
+    void checkpoint(uint32_t checksum) {
+        flushRun();
+        putByte(REPLAY_CHECK);
+        putBytes(&checksum, sizeof(checksum));
+        ticksSinceCheck = 0;
+        handOff(false);
+    }
+
+    uint64_t getTicksRecorded() const { return ticksRecorded; }
+    uint64_t getGamesRecorded() const { return gamesRecorded; }
+    uint64_t getBytesEncoded() const { return bytesEncoded + chunk.size(); }
 };
 
-// Phantom Enemy - Fades in and out
-class PhantomEnemy : public Enemy {
+// Decodes a recording as it goes; only the stream's buffer is in memory,
+// however long the session was
+class ReplayReader {
+public:
+    enum class Step { Tick, Game, Check, End };
+
 private:
-    float fadeTimer;
-    bool isVisible;
+    ifstream file;
+    float tickRate = SIMULATION_TICK_RATE;
+    uint8_t bits = 0;
+    uint64_t ticksLeft = 0;   // of the current run
+    uint64_t seed = 0;
+    float difficulty = 1.0f;
+    uint32_t checksum = 0;
+
+    bool readVarint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            int byte = file.get();
+            if (byte == EOF) return false;
+            value |= uint64_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
 
 public:
-    PhantomEnemy(int level, int phase) : Enemy(EnemyType::Phantom, level, phase), fadeTimer(2.0f), isVisible(true) {
-        setupSprite("enemy_phantom", 0.8f);
-        health = 50 + level * 15;
-        maxHealth = health;
-        scoreValue = 250 + level * 45;
-        velocity = Vector2(RandomGenerator::range(-50.0f, 50.0f), RandomGenerator::range(70.0f, 100.0f));
-        fireRate = 1.3f;
+    bool open(const string& path) {
+        file.open(path, ios::binary);
+        ReplayHeader header;
+        if (!file.is_open() || !file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+            cerr << "[FAIL] Could not read replay: " << path << endl;
+            return false;
+        }
+        if (memcmp(header.magic, "SSRP", 4) != 0 || header.version != REPLAY_VERSION) {
+            cerr << "[FAIL] Not a replay, or from another version: " << path << endl;
+            return false;
+        }
+        tickRate = header.tickRate;
+        cout << "[OK] Replaying: " << path << endl;
+        return true;
     }
 
-    void update(float dt) override {
-        fadeTimer -= dt;
-        if (fadeTimer <= 0) {
-            isVisible = !isVisible;
-            fadeTimer = 2.0f;
+    // Advances to the next tick or record. A truncated file (the game was
+    // killed mid-recording) simply ends.
+    Step next() {
+        while (ticksLeft == 0) {
+            int type = file.get();
+            if (type == REPLAY_INPUT) {
+                int changed = file.get();
+                if (changed == EOF || !readVarint(ticksLeft)) return Step::End;
+                bits ^= static_cast<uint8_t>(changed);
+            }
+            else if (type == REPLAY_GAME) {
+                if (!file.read(reinterpret_cast<char*>(&seed), sizeof(seed)) ||
+                    !file.read(reinterpret_cast<char*>(&difficulty), sizeof(difficulty))) return Step::End;
+                bits = 0;
+                return Step::Game;
+            }
+            else if (type == REPLAY_CHECK) {
+                if (!file.read(reinterpret_cast<char*>(&checksum), sizeof(checksum))) return Step::End;
+                return Step::Check;
+            }
+            else {
+                return Step::End;
+            }
         }
-
-        sf::Uint8 alpha = isVisible ? 255 : 80;
-        sprite.setColor(sf::Color(255, 255, 255, alpha));
-
-        Enemy::update(dt);
+        ticksLeft--;
+        return Step::Tick;
     }
+
+    float getTickRate() const { return tickRate; }
+    uint8_t getBits() const { return bits; }
+    uint64_t getSeed() const { return seed; }
+    float getDifficulty() const { return difficulty; }
+    uint32_t getChecksum() const { return checksum; }
 };
 
-// Dragon Enemy - Mini-boss, complex movement
-class DragonEnemy : public Enemy {
-private:
-    float stateTimer;
-    int state;
-    float angleOffset;
+#ifdef PERF_OVERLAY
+// ============================================================================
+// PERFORMANCE OVERLAY - F3 during gameplay (debug builds only)
+// ============================================================================
+//
+// Frame time, a rolling frame-time graph, CPU time per subsystem and live
+// counts, drawn over the gameplay screen. The graph is one vertex array and
+// the numbers are one sf::Text, rebuilt a few times a second from averages,
+// so the overlay costs two draw calls and next to no CPU.
 
-public:
-    DragonEnemy(int level, int phase) : Enemy(EnemyType::Dragon, level, phase), stateTimer(3.0f), state(0), angleOffset(0) {
-        setupSprite("enemy_dragon", 1.0f);
-        health = 200 + level * 50;
-        maxHealth = health;
-        scoreValue = 500 + level * 100;
-        velocity = Vector2(0, 0);
-        fireRate = 0.5f;
-        boundingRadius = 40.0f;
+class PerfOverlay {
+private:
+    static const int GRAPH_SAMPLES = 240;
+    static constexpr float GRAPH_LEFT = 10.0f;
+    static constexpr float GRAPH_TOP = 160.0f;
+    static constexpr float GRAPH_HEIGHT = 60.0f;
+    static constexpr float GRAPH_MAX_MS = 50.0f;
+    static constexpr double REFRESH_SECONDS = 0.25;
+
+    array<float, GRAPH_SAMPLES> frameMs = {};
+    int nextSample = 0;
+    sf::VertexArray graph;
+    sf::Text text;
+    char textBuffer[640];
+
+    // Totals since the text was last rebuilt
+    TickTimings simulation;
+    double inputMs = 0, drawMs = 0, hudMs = 0, frameTotalMs = 0, worstFrameMs = 0;
+    int frames = 0;
+    chrono::steady_clock::time_point lastRefresh = chrono::steady_clock::now();
+
+    static void setQuad(sf::Vertex* v, float left, float top, float right, float bottom, sf::Color color) {
+        const sf::Vector2f corners[6] = { { left, top }, { right, top }, { right, bottom },
+            { left, top }, { right, bottom }, { left, bottom } };
+        for (int i = 0; i < 6; i++) {
+            v[i].position = corners[i];
+            v[i].color = color;
+        }
     }
 
-    void update(float dt) override {
-        stateTimer -= dt;
-        angleOffset += dt;
-
-        // Circle movement
-        position.x = SCREEN_WIDTH / 2 + cos(angleOffset) * 200;
-        position.y = 150 + sin(angleOffset * 0.5f) * 50;
+    void rebuildText(const EntityCounts& counts, size_t drawCalls) {
+        double n = max(frames, 1);
+        snprintf(textBuffer, sizeof(textBuffer),
+            "frame %5.2f ms (%3.0f fps)  worst %5.2f ms\n"
+            "input %5.3f  draw %5.3f  hud %5.3f ms\n"
+            "player %5.3f  enemies %5.3f  boss %5.3f\n"
+            "bullets %5.3f  other %5.3f  particles %5.3f\n"
+            "collisions %5.3f  removeInactive %5.3f ms\n"
+            "enemies %zu  bullets %zu  particles %zu  explosions %zu\n"
+            "draw calls %zu",
+            frameTotalMs / n, 1000.0 * n / max(frameTotalMs, 0.001), worstFrameMs,
+            inputMs / n, drawMs / n, hudMs / n,
+            simulation.player / n, simulation.enemies / n, simulation.boss / n,
+            simulation.bullets / n, simulation.other / n, simulation.particles / n,
+            simulation.collision / n, simulation.cleanup / n,
+            counts.enemies, counts.bullets, counts.particles, counts.explosions,
+            drawCalls);
+        text.setString(textBuffer);
+
+        simulation = TickTimings();
+        inputMs = drawMs = hudMs = frameTotalMs = worstFrameMs = 0;
+        frames = 0;
+    }
 
-        sprite.setPosition(position.x, position.y);
-        fireTimer -= dt;
+public:
+    // Background, a 60 fps and a 30 fps line, then one bar per sample
+    PerfOverlay() : graph(sf::Triangles, (3 + GRAPH_SAMPLES) * 6) {
+        const float right = GRAPH_LEFT + GRAPH_SAMPLES * 2.0f;
+        const float bottom = GRAPH_TOP + GRAPH_HEIGHT;
+        setQuad(&graph[0], GRAPH_LEFT, GRAPH_TOP, right, bottom, sf::Color(0, 0, 0, 160));
+        for (int line = 0; line < 2; line++) {
+            float y = bottom - (line == 0 ? 1000.0f / 60.0f : 1000.0f / 30.0f) / GRAPH_MAX_MS * GRAPH_HEIGHT;
+            setQuad(&graph[(1 + line) * 6], GRAPH_LEFT, y, right, y + 1.0f, sf::Color(255, 255, 255, 90));
+        }
+        text.setCharacterSize(14);
+        text.setFillColor(sf::Color(220, 255, 220));
+        text.setPosition(GRAPH_LEFT, GRAPH_TOP + GRAPH_HEIGHT + 6.0f);
+        textBuffer[0] = '\0';
+    }
 
-        if (health <= 0) active = false;
+    void setFont(const sf::Font& font) { text.setFont(font); }
+
+    // Once per drawn frame. sim covers the ticks behind the snapshot drawn.
+    void addFrame(double frameMillis, double inputMillis, double drawMillis, double hudMillis, const TickTimings& sim,
+        const EntityCounts& counts, size_t drawCalls) {
+        frameMs[nextSample] = static_cast<float>(frameMillis);
+        nextSample = (nextSample + 1) % GRAPH_SAMPLES;
+
+        simulation += sim;
+        inputMs += inputMillis;
+        drawMs += drawMillis;
+        hudMs += hudMillis;
+        frameTotalMs += frameMillis;
+        worstFrameMs = max(worstFrameMs, frameMillis);
+        frames++;
+
+        auto now = chrono::steady_clock::now();
+        if (chrono::duration<double>(now - lastRefresh).count() >= REFRESH_SECONDS) {
+            rebuildText(counts, drawCalls);
+            lastRefresh = now;
+        }
     }
 
-    void draw(sf::RenderWindow& window) override {
-        GameObject::draw(window);
-        drawHealthBar(window, 60.0f, -50.0f);
+    void draw(sf::RenderTarget& target) {
+        // Oldest sample on the left
+        const float bottom = GRAPH_TOP + GRAPH_HEIGHT;
+        for (int i = 0; i < GRAPH_SAMPLES; i++) {
+            float ms = frameMs[(nextSample + i) % GRAPH_SAMPLES];
+            float height = min(ms / GRAPH_MAX_MS, 1.0f) * GRAPH_HEIGHT;
+            sf::Color color = ms <= 1000.0f / 60.0f + 1.0f ? sf::Color(80, 220, 80)
+                : ms <= 1000.0f / 30.0f ? sf::Color(240, 200, 60) : sf::Color(240, 70, 70);
+            float left = GRAPH_LEFT + i * 2.0f;
+            setQuad(&graph[(3 + i) * 6], left, bottom - height, left + 2.0f, bottom, color);
+        }
+        drawCounted(target, graph);
+        drawCounted(target, text);
     }
 };
+#endif
 
 // ============================================================================
-// FINAL BOSS CLASS
+// RETAINED HUD - Text and bars rebuilt only when their value changes
 // ============================================================================
+//
+// sf::Text regenerates its glyph quads whenever its string is set, and a
+// RectangleShape its outline whenever it is resized. The HUD keeps every
+// element alive across frames and formats into fixed buffers, so SFML only
+// sees a new string or size when the score, lives, HP and so on changed.
 
-class FinalBoss : public GameObject {
+class HudLabel {
 private:
-    int bossPhase;
-    float phaseTimer;
-    float attackTimer;
-    float moveAngle;
-    Vector2 playerPos;
-    sf::Sprite eyeSprite;
-    int attackPattern;
-    vector<unique_ptr<Bullet>> pendingBullets;
-    bool isEnraged;
-    float shieldTimer;
-    bool hasShield;
+    sf::Text text;
+    char shown[64] = "";
+    const char* boundPattern = nullptr;   // what format() last printed, and with what
+    array<long long, 4> boundValues = {};
+
+    void setText(const char* value) {
+        if (strcmp(value, shown) == 0) return;
+        snprintf(shown, sizeof(shown), "%s", value);
+        text.setString(shown);
+    }
 
 public:
-    FinalBoss() : bossPhase(1), phaseTimer(0), attackTimer(0), moveAngle(0), attackPattern(0), isEnraged(false), shieldTimer(0), hasShield(true) {
-        setupSprite("boss", 1.5f);
-        health = 500.0f;
-        maxHealth = 500.0f;
-        boundingRadius = 80.0f;
-        position = Vector2(SCREEN_WIDTH / 2, -150);
+    void setup(unsigned characterSize, sf::Color color, float x, float y) {
+        text.setCharacterSize(characterSize);
+        text.setFillColor(color);
+        text.setPosition(x, y);
+    }
 
-        TextureManager& tm = TextureManager::getInstance();
-        if (tm.hasTexture("boss_eye")) {
-            eyeSprite.setTexture(tm.getTexture("boss_eye"));
-            eyeSprite.setOrigin(eyeSprite.getTexture()->getSize().x / 2.0f,
-                eyeSprite.getTexture()->getSize().y / 2.0f);
-        }
+    void setFont(const sf::Font& font) { text.setFont(font); }
+
+    void show(const char* value) {
+        boundPattern = nullptr;
+        setText(value);
     }
 
-    void update(float dt) override {
-        // Entry animation
-        if (position.y < 150) {
-            position.y += 50.0f * dt;
-            sprite.setPosition(position.x, position.y);
-            eyeSprite.setPosition(position.x, position.y - 10);
-            return;
-        }
+    // printf-style with integer arguments; skips the formatting too while
+    // they are the ones the label already shows
+    template <typename... Args>
+    void format(const char* pattern, Args... args) {
+        static_assert(sizeof...(Args) <= 4, "HudLabel::format takes up to four values");
+        array<long long, 4> values = { static_cast<long long>(args)... };
+        if (pattern == boundPattern && values == boundValues) return;
+        boundPattern = pattern;
+        boundValues = values;
+
+        char value[sizeof(shown)];
+        snprintf(value, sizeof(value), pattern, args...);
+        setText(value);
+    }
 
-        attackTimer -= dt;
-        moveAngle += dt;
-        phaseTimer += dt;
-        shieldTimer -= dt;
+    void setColor(sf::Color color) {
+        if (text.getFillColor() != color) text.setFillColor(color);
+    }
 
-        // Update boss phase based on health
-        float healthPercent = health / maxHealth;
-        if (healthPercent <= 0.3f) {
-            bossPhase = 3;
-            isEnraged = true;
-        }
-        else if (healthPercent <= 0.6f) {
-            bossPhase = 2;
-        }
+    void setPosition(float x, float y) { text.setPosition(x, y); }
 
-        // Movement patterns
-        switch (bossPhase) {
-        case 1:
-            position.x = SCREEN_WIDTH / 2 + sin(moveAngle * 0.8f) * 250;
-            position.y = 150 + sin(moveAngle * 0.5f) * 30;
-            break;
-        case 2:
-            position.x = SCREEN_WIDTH / 2 + sin(moveAngle * 1.2f) * 300;
-            position.y = 120 + sin(moveAngle * 0.8f) * 50;
-            break;
-        case 3:
-            position.x = SCREEN_WIDTH / 2 + sin(moveAngle * 1.5f) * 350;
-            position.y = 100 + sin(moveAngle) * 80;
-            break;
-        }
+    void draw(sf::RenderTarget& target) const { drawCounted(target, text); }
+};
+
+class HudBar {
+private:
+    sf::RectangleShape background;
+    sf::RectangleShape fill;
+    sf::Vector2f size;
+    float fraction = 0;
 
-        // Shield regeneration
-        if (shieldTimer <= 0 && !hasShield && bossPhase >= 2) {
-            hasShield = true;
-            shieldTimer = 10.0f;
+public:
+    void setup(float x, float y, float width, float height, sf::Color backColor,
+        sf::Color outlineColor, float outlineThickness) {
+        size = sf::Vector2f(width, height);
+        background.setSize(size);
+        background.setPosition(x, y);
+        background.setFillColor(backColor);
+        background.setOutlineColor(outlineColor);
+        background.setOutlineThickness(outlineThickness);
+        fill.setSize(sf::Vector2f(0, height));
+        fill.setPosition(x, y);
+    }
+
+    void setValue(float value, sf::Color color) {
+        value = max(0.0f, min(value, 1.0f));
+        if (value != fraction) {
+            fraction = value;
+            fill.setSize(sf::Vector2f(size.x * fraction, size.y));
         }
+        if (fill.getFillColor() != color) fill.setFillColor(color);
+    }
 
-        sprite.setPosition(position.x, position.y);
+    void draw(sf::RenderTarget& target) const {
+        drawCounted(target, background);
+        drawCounted(target, fill);
+    }
+};
 
-        // Eye follows player
-        Vector2 toPlayer = (playerPos - position).normalized();
-        eyeSprite.setPosition(position.x + toPlayer.x * 15, position.y - 10 + toPlayer.y * 10);
+class RetainedHud {
+private:
+    static constexpr float PLAYER_LEFT = 20.0f;
+    static constexpr float BOSS_BAR_WIDTH = 500.0f;
+    static constexpr float BOSS_BAR_TOP = 20.0f;
+    const float playerBarTop = SCREEN_HEIGHT - 50.0f;
+    const float bossBarLeft = (SCREEN_WIDTH - BOSS_BAR_WIDTH) / 2;
 
-        // Enraged color
-        if (isEnraged) {
-            float pulse = sin(phaseTimer * 8) * 0.3f + 0.7f;
-            sprite.setColor(sf::Color(255, static_cast<sf::Uint8>(100 * pulse), static_cast<sf::Uint8>(100 * pulse)));
-        }
+    HudBar healthBar, shieldBar, bossBar;
+    HudLabel healthLabel, livesLabel, scoreLabel, comboLabel, powerLabel;
+    HudLabel bossNameLabel, bossPhaseLabel;
+    HudLabel levelLabel, enemiesLabel, bossBattleLabel, slowTimeLabel;
+
+    HudLabel* labels[11] = { &healthLabel, &livesLabel, &scoreLabel, &comboLabel, &powerLabel,
+        &bossNameLabel, &bossPhaseLabel, &levelLabel, &enemiesLabel, &bossBattleLabel, &slowTimeLabel };
+
+public:
+    RetainedHud() {
+        healthBar.setup(PLAYER_LEFT, playerBarTop, 200.0f, 20.0f, sf::Color(40, 40, 40), sf::Color::White, 2);
+        shieldBar.setup(PLAYER_LEFT, playerBarTop - 15, 200.0f, 10.0f, sf::Color(20, 20, 60),
+            sf::Color(100, 150, 255), 1);
+        bossBar.setup(bossBarLeft, BOSS_BAR_TOP, BOSS_BAR_WIDTH, 30.0f, sf::Color(40, 0, 0),
+            sf::Color(200, 50, 50), 3);
+
+        healthLabel.setup(14, sf::Color::White, PLAYER_LEFT + 5, playerBarTop + 2);
+        livesLabel.setup(20, sf::Color(255, 100, 100), PLAYER_LEFT, playerBarTop - 40);
+        scoreLabel.setup(24, sf::Color(255, 220, 100), 20, 20);
+        comboLabel.setup(28, sf::Color(255, 150, 50), 20, 50);
+        powerLabel.setup(16, sf::Color(150, 200, 255), 20, 85);
+
+        bossNameLabel.setup(24, sf::Color(255, 200, 100), bossBarLeft, BOSS_BAR_TOP - 30);
+        bossPhaseLabel.setup(16, sf::Color::White, bossBarLeft + BOSS_BAR_WIDTH + 10, BOSS_BAR_TOP + 5);
+
+        levelLabel.setup(20, sf::Color(150, 200, 255), SCREEN_WIDTH - 250, 20);
+        enemiesLabel.setup(16, sf::Color(200, 150, 150), SCREEN_WIDTH - 250, 50);
+        bossBattleLabel.setup(20, sf::Color(255, 100, 100), SCREEN_WIDTH - 220, 60);
+        bossBattleLabel.show("=== BOSS BATTLE ===");
+        slowTimeLabel.setup(24, sf::Color(100, 255, 255), SCREEN_WIDTH / 2 - 80, 100);
     }
 
-    void draw(sf::RenderWindow& window) override {
-        // Draw shield if active
-        if (hasShield) {
-            sf::CircleShape shieldCircle(boundingRadius + 20);
-            shieldCircle.setOrigin(boundingRadius + 20, boundingRadius + 20);
-            shieldCircle.setPosition(position.x, position.y);
-            shieldCircle.setFillColor(sf::Color(100, 150, 255, 60));
-            shieldCircle.setOutlineColor(sf::Color(150, 200, 255, 150));
-            shieldCircle.setOutlineThickness(3);
-            window.draw(shieldCircle);
-        }
-
-        GameObject::draw(window);
-        window.draw(eyeSprite);
-    }
-
-    void drawBossHealthBar(sf::RenderWindow& window, sf::Font& font) {
-        float barWidth = 500.0f;
-        float barHeight = 30.0f;
-        float startX = (SCREEN_WIDTH - barWidth) / 2;
-        float startY = 20.0f;
-
-        // Boss name
-        sf::Text bossName;
-        bossName.setFont(font);
-        bossName.setString("EMPEROR DESTRUCTON" + string(isEnraged ? " [ENRAGED]" : ""));
-        bossName.setCharacterSize(24);
-        bossName.setFillColor(isEnraged ? sf::Color(255, 100, 100) : sf::Color(255, 200, 100));
-        bossName.setPosition(startX, startY - 30);
-        window.draw(bossName);
-
-        // Health bar background
-        sf::RectangleShape bg(sf::Vector2f(barWidth, barHeight));
-        bg.setPosition(startX, startY);
-        bg.setFillColor(sf::Color(40, 0, 0));
-        bg.setOutlineColor(sf::Color(200, 50, 50));
-        bg.setOutlineThickness(3);
-        window.draw(bg);
-
-        // Health bar fill
-        float healthPercent = health / maxHealth;
-        sf::Color barColor;
-        if (bossPhase == 1) barColor = sf::Color(200, 50, 50);
-        else if (bossPhase == 2) barColor = sf::Color(255, 150, 0);
-        else barColor = sf::Color(255, 50, 150);
-
-        sf::RectangleShape bar(sf::Vector2f(barWidth * healthPercent, barHeight));
-        bar.setPosition(startX, startY);
-        bar.setFillColor(barColor);
-        window.draw(bar);
-
-        // Phase indicator
-        sf::Text phaseText;
-        phaseText.setFont(font);
-        phaseText.setString("Phase " + to_string(bossPhase) + "/3");
-        phaseText.setCharacterSize(16);
-        phaseText.setFillColor(sf::Color::White);
-        phaseText.setPosition(startX + barWidth + 10, startY + 5);
-        window.draw(phaseText);
+    void setFont(const sf::Font& font) {
+        for (HudLabel* label : labels) label->setFont(font);
     }
 
-    void takeDamage(float dmg) {
-        if (hasShield) {
-            dmg *= 0.3f;
-            shieldTimer -= 2.0f;
-            if (shieldTimer <= 0) hasShield = false;
+    // Health, shield, lives, score, combo and power
+    void drawPlayer(sf::RenderTarget& target, const HudValues& hud) {
+        float healthPercent = hud.health / hud.maxHealth;
+        healthBar.setValue(healthPercent, healthPercent > 0.5f ? sf::Color(50, 200, 50) :
+            healthPercent > 0.25f ? sf::Color(255, 200, 0) : sf::Color(220, 50, 50));
+        healthBar.draw(target);
+        healthLabel.format("HP: %d/%d", static_cast<int>(hud.health), static_cast<int>(hud.maxHealth));
+        healthLabel.draw(target);
+
+        if (hud.hasShield) {
+            shieldBar.setValue(hud.shield / hud.maxShield, sf::Color(100, 180, 255));
+            shieldBar.draw(target);
         }
-        health -= dmg;
-        SoundManager::getInstance().playSound("boss_hit");
-        if (health <= 0) active = false;
-    }
 
-    vector<unique_ptr<Bullet>> getAttackBullets() {
-        vector<unique_ptr<Bullet>> bullets;
+        livesLabel.format("Lives: %d", hud.lives);
+        livesLabel.setPosition(PLAYER_LEFT, playerBarTop - 40 - (hud.hasShield ? 15 : 0));
+        livesLabel.draw(target);
 
-        if (attackTimer > 0 || position.y < 150) return bullets;
+        scoreLabel.format("Score: %d", hud.score);
+        scoreLabel.draw(target);
 
-        float attackDelay;
-        switch (bossPhase) {
-        case 1: attackDelay = 0.8f; break;
-        case 2: attackDelay = 0.5f; break;
-        case 3: attackDelay = 0.3f; break;
-        default: attackDelay = 1.0f;
+        if (hud.combo > 1) {
+            comboLabel.format("COMBO x%d", hud.combo);
+            comboLabel.draw(target);
         }
-        attackTimer = attackDelay;
-        attackPattern = (attackPattern + 1) % 4;
 
-        // Different attack patterns
-        switch (attackPattern) {
-        case 0: // Spread shot
-        {
-            int bulletCount = 5 + bossPhase * 2;
-            float angleSpread = 60.0f + bossPhase * 20.0f;
-            float startAngle = 90.0f - angleSpread / 2;
+        powerLabel.format("Power: %d | Shots: %d", hud.powerLevel, hud.multiShotLevel);
+        powerLabel.draw(target);
+    }
 
-            for (int i = 0; i < bulletCount; i++) {
-                float angle = (startAngle + (angleSpread / (bulletCount - 1)) * i) * PI / 180.0f;
-                auto bullet = make_unique<Bullet>(false, 15 + bossPhase * 5, true);
-                bullet->setPosition(position + Vector2(0, 40));
-                bullet->setVelocity(Vector2(cos(angle) * 250, sin(angle) * 250));
-                bullets.push_back(move(bullet));
-            }
-            break;
-        }
-        case 1: // Aimed shot
-        {
-            Vector2 dir = (playerPos - position).normalized();
-            for (int i = -1; i <= 1; i++) {
-                auto bullet = make_unique<Bullet>(false, 20 + bossPhase * 5, true);
-                bullet->setPosition(position + Vector2(i * 30, 40));
-                bullet->setVelocity(dir * 350.0f);
-                bullets.push_back(move(bullet));
-            }
-            break;
-        }
-        case 2: // Circular burst
-        {
-            int bulletCount = 8 + bossPhase * 4;
-            for (int i = 0; i < bulletCount; i++) {
-                float angle = (360.0f / bulletCount * i + phaseTimer * 30) * PI / 180.0f;
-                auto bullet = make_unique<Bullet>(false, 10 + bossPhase * 3, true);
-                bullet->setPosition(position);
-                bullet->setVelocity(Vector2(cos(angle) * 200, sin(angle) * 200));
-                bullets.push_back(move(bullet));
-            }
-            break;
-        }
-        case 3: // Spiral
-        {
-            if (bossPhase >= 2) {
-                for (int i = 0; i < 3; i++) {
-                    float angle = (phaseTimer * 100 + i * 120) * PI / 180.0f;
-                    auto bullet = make_unique<Bullet>(false, 12 + bossPhase * 4, true);
-                    bullet->setPosition(position);
-                    bullet->setVelocity(Vector2(cos(angle) * 220, sin(angle) * 220));
-                    bullets.push_back(move(bullet));
-                }
-            }
-            break;
+    void drawBoss(sf::RenderTarget& target, const HudValues& hud) {
+        bossNameLabel.show(hud.bossEnraged ? "EMPEROR DESTRUCTON [ENRAGED]" : "EMPEROR DESTRUCTON");
+        bossNameLabel.setColor(hud.bossEnraged ? sf::Color(255, 100, 100) : sf::Color(255, 200, 100));
+        bossNameLabel.draw(target);
+
+        bossBar.setValue(hud.bossHealthFraction, hud.bossPhase == 1 ? sf::Color(200, 50, 50) :
+            hud.bossPhase == 2 ? sf::Color(255, 150, 0) : sf::Color(255, 50, 150));
+        bossBar.draw(target);
+
+        bossPhaseLabel.format("Phase %d/3", hud.bossPhase);
+        bossPhaseLabel.draw(target);
+    }
+
+    // Level and phase (or the boss battle banner), and the slow-time countdown
+    void drawLevel(sf::RenderTarget& target, const HudValues& hud) {
+        if (!hud.bossLevel) {
+            levelLabel.format("Level %d - Phase %d/%d", hud.level, hud.phase, PHASES_PER_LEVEL);
+            levelLabel.draw(target);
+            enemiesLabel.format("Enemies: %zu", hud.enemyCount);
+            enemiesLabel.draw(target);
         }
+        else {
+            bossBattleLabel.draw(target);
         }
 
-        return bullets;
+        if (hud.slowTimeLeft > 0) {
+            slowTimeLabel.format("SLOW TIME: %ds", static_cast<int>(hud.slowTimeLeft));
+            slowTimeLabel.draw(target);
+        }
     }
-
-    void setPlayerPosition(const Vector2& pos) { playerPos = pos; }
-    int getBossPhase() const { return bossPhase; }
-    bool hasActiveShield() const { return hasShield; }
 };
 
 // ============================================================================
-// POWER-UP CLASS
+// RENDER LAYERS - Screens composited from cached and live layers
 // ============================================================================
+//
+// A screen is a list of layers drawn in a fixed order. A dynamic layer draws
+// straight to the window every frame. A static one is rendered once into its
+// own sf::RenderTexture and then costs one sprite draw per frame until it is
+// invalidated (a screen change, a swapped background, a toggled setting).
+// Where render textures aren't available, static layers draw directly.
 
-class PowerUp : public GameObject {
-private:
-    PowerUpType type;
-    float lifetime;
-    float bobTimer;
+enum class LayerKind { Static, Dynamic };
 
+template <typename Owner>
+class LayerStack {
 public:
-    PowerUp(PowerUpType t) : type(t), lifetime(12.0f), bobTimer(0) {
-        string textureName;
-        switch (type) {
-        case PowerUpType::Power: textureName = "powerup_power"; break;
-        case PowerUpType::Fire: textureName = "powerup_fire"; break;
-        case PowerUpType::Shield: textureName = "powerup_shield"; break;
-        case PowerUpType::Lives: textureName = "powerup_lives"; break;
-        case PowerUpType::Nuke: textureName = "powerup_nuke"; break;
-        case PowerUpType::MultiShot: textureName = "powerup_multishot"; break;
-        case PowerUpType::Slow: textureName = "powerup_slow"; break;
-        case PowerUpType::Danger: textureName = "powerup_danger"; break;
-        }
-        setupSprite(textureName, 1.0f);
-        velocity = Vector2(RandomGenerator::range(-20.0f, 20.0f), RandomGenerator::range(40.0f, 80.0f));
-        boundingRadius = 15.0f;
+    using RenderFunction = void (Owner::*)(sf::RenderTarget&);
+
+private:
+    struct Layer {
+        const char* name;
+        LayerKind kind;
+        RenderFunction render;
+        unique_ptr<sf::RenderTexture> cache;   // created on first use
+        sf::Sprite sprite;
+        bool valid = false;
+        bool failed = false;                   // no render texture; draw directly
+    };
+
+    vector<Layer> layers;
+    uint64_t rebuilds = 0;
+
+    // The cache holds premultiplied colour (blending onto transparent black
+    // multiplies by alpha once already), so it is composited accordingly
+    static sf::RenderStates compositeStates() {
+        return sf::RenderStates(sf::BlendMode(sf::BlendMode::One, sf::BlendMode::OneMinusSrcAlpha));
     }
 
-    void update(float dt) override {
-        GameObject::update(dt);
-        lifetime -= dt;
-        bobTimer += dt;
-        rotation += 90.0f * dt;
+    bool prepare(Layer& layer) {
+        if (layer.cache || layer.failed) return !layer.failed;
+        layer.cache = make_unique<sf::RenderTexture>();
+        if (!layer.cache->create(static_cast<unsigned>(SCREEN_WIDTH), static_cast<unsigned>(SCREEN_HEIGHT))) {
+            cerr << "[FAIL] Could not create a render texture for layer: " << layer.name << endl;
+            layer.cache.reset();
+            layer.failed = true;
+            return false;
+        }
+        layer.sprite.setTexture(layer.cache->getTexture(), true);
+        return true;
+    }
 
-        // Bob up and down
-        sprite.setPosition(position.x, position.y + sin(bobTimer * 4) * 5);
-        sprite.setRotation(rotation);
+public:
+    void add(const char* name, LayerKind kind, RenderFunction render) {
+        layers.push_back({ name, kind, render, nullptr, sf::Sprite(), false, false });
+    }
 
-        if (lifetime <= 0 || position.y > SCREEN_HEIGHT + 50) {
-            active = false;
+    void invalidate() {
+        for (Layer& layer : layers) layer.valid = false;
+    }
+
+    void invalidate(const char* name) {
+        for (Layer& layer : layers) {
+            if (strcmp(layer.name, name) == 0) layer.valid = false;
         }
+    }
 
-        // Blink when about to expire
-        if (lifetime < 3.0f) {
-            float alpha = 128 + sin(lifetime * 10) * 127;
-            sprite.setColor(sf::Color(255, 255, 255, static_cast<sf::Uint8>(alpha)));
+    void draw(sf::RenderTarget& target, Owner& owner) {
+        for (Layer& layer : layers) {
+            if (layer.kind == LayerKind::Dynamic || !prepare(layer)) {
+                (owner.*layer.render)(target);
+                continue;
+            }
+            if (!layer.valid) {
+                layer.cache->clear(sf::Color::Transparent);
+                (owner.*layer.render)(*layer.cache);
+                layer.cache->display();
+                layer.valid = true;
+                rebuilds++;
+            }
+            target.draw(layer.sprite, compositeStates());
+            countDrawCalls();
         }
     }
 
-    PowerUpType getType() const { return type; }
+    // Static layer renders so far, for checking that a still screen stays cached
+    uint64_t getRebuildCount() const { return rebuilds; }
 };
 
 // ============================================================================
-// EXPLOSION ANIMATION
+// RETAINED UI - Menu and end screens built once, drawn from cached vertices
 // ============================================================================
+//
+// Each screen is a UiScreen: a flat list of widgets (text, outlined boxes,
+// sprites) laid out once when the screen is built. Changing a widget's text
+// or colour marks only that widget dirty; the next draw regenerates its quads
+// and regathers the screen's vertex arrays, one per texture (a font page per
+// character size, a sprite's texture, none for boxes). With nothing dirty a
+// screen just draws its cached arrays.
+
+class UiScreen {
+public:
+    using WidgetId = size_t;
 
-class Explosion : public GameObject {
 private:
-    int currentFrame;
-    int totalFrames;
-    float frameTime;
-    float frameTimer;
-    float frameWidth;
+    enum class WidgetKind { Text, Box, Sprite };
+
+    struct Widget {
+        WidgetKind kind;
+        string text;
+        unsigned characterSize = 0;
+        sf::Color color;
+        sf::Vector2f position;
+        sf::Vector2f size;                    // boxes
+        sf::Color outlineColor;
+        float outlineThickness = 0;
+        const sf::Sprite* sprite = nullptr;   // owned by the caller
+        bool visible = true;
+        bool dirty = true;
+        const sf::Texture* texture = nullptr; // what the vertices sample
+        vector<sf::Vertex> vertices;
+    };
 
-public:
-    Explosion(const Vector2& pos, float scale = 1.0f) : currentFrame(0), totalFrames(8), frameTime(0.08f), frameTimer(0) {
-        position = pos;
-        TextureManager& tm = TextureManager::getInstance();
-        if (tm.hasTexture("explosion")) {
-            sprite.setTexture(tm.getTexture("explosion"));
-            frameWidth = sprite.getTexture()->getSize().x / totalFrames;
-            sprite.setTextureRect(sf::IntRect(0, 0, static_cast<int>(frameWidth), sprite.getTexture()->getSize().y));
-            sprite.setOrigin(frameWidth / 2, sprite.getTexture()->getSize().y / 2.0f);
-            sprite.setScale(scale, scale);
-            sprite.setPosition(pos.x, pos.y);
+    struct Batch {
+        const sf::Texture* texture;
+        vector<sf::Vertex> vertices;
+    };
+
+    const sf::Font* font = nullptr;
+    vector<Widget> widgets;
+    vector<Batch> batches;
+    bool dirty = true;
+    uint64_t widgetBuilds = 0;
+
+    static void appendQuad(vector<sf::Vertex>& out, const sf::Vector2f (&corners)[4], sf::Color color,
+        const sf::Vector2f (&uvs)[4]) {
+        const int order[6] = { 0, 1, 2, 0, 2, 3 };
+        for (int i : order) out.emplace_back(corners[i], color, uvs[i]);
+    }
+
+    static void appendRect(vector<sf::Vertex>& out, float left, float top, float right, float bottom, sf::Color color) {
+        if (right <= left || bottom <= top) return;
+        const sf::Vector2f corners[4] = { { left, top }, { right, top }, { right, bottom }, { left, bottom } };
+        const sf::Vector2f uvs[4] = {};
+        appendQuad(out, corners, color, uvs);
+    }
+
+    // The same glyph layout as sf::Text (no styles or outline)
+    void buildText(Widget& widget) {
+        if (!font || widget.text.empty()) return;
+        const unsigned size = widget.characterSize;
+        const float whitespace = font->getGlyph(L' ', size, false).advance;
+        const float lineSpacing = font->getLineSpacing(size);
+        const float padding = 1.0f;
+
+        float x = 0, y = static_cast<float>(size);
+        sf::Uint32 previous = 0;
+        for (unsigned char c : widget.text) {
+            x += font->getKerning(previous, c, size);
+            previous = c;
+            if (c == ' ') { x += whitespace; continue; }
+            if (c == '\t') { x += whitespace * 4; continue; }
+            if (c == '\n') { y += lineSpacing; x = 0; continue; }
+
+            const sf::Glyph& glyph = font->getGlyph(c, size, false);
+            float left = widget.position.x + x + glyph.bounds.left - padding;
+            float top = widget.position.y + y + glyph.bounds.top - padding;
+            float right = left + glyph.bounds.width + 2 * padding;
+            float bottom = top + glyph.bounds.height + 2 * padding;
+            float u1 = glyph.textureRect.left - padding;
+            float v1 = glyph.textureRect.top - padding;
+            float u2 = glyph.textureRect.left + glyph.textureRect.width + padding;
+            float v2 = glyph.textureRect.top + glyph.textureRect.height + padding;
+            const sf::Vector2f corners[4] = { { left, top }, { right, top }, { right, bottom }, { left, bottom } };
+            const sf::Vector2f uvs[4] = { { u1, v1 }, { u2, v1 }, { u2, v2 }, { u1, v2 } };
+            appendQuad(widget.vertices, corners, widget.color, uvs);
+            x += glyph.advance;
         }
+        // After the glyphs, which may have added to the page
+        widget.texture = &font->getTexture(size);
     }
 
-    void update(float dt) override {
-        frameTimer += dt;
-        if (frameTimer >= frameTime) {
-            frameTimer = 0;
-            currentFrame++;
-            if (currentFrame >= totalFrames) {
-                active = false;
+    // Outline outside the box, as with sf::RectangleShape
+    void buildBox(Widget& widget) {
+        const float t = widget.outlineThickness;
+        const float left = widget.position.x, top = widget.position.y;
+        const float right = left + widget.size.x, bottom = top + widget.size.y;
+        appendRect(widget.vertices, left, top, right, bottom, widget.color);
+        appendRect(widget.vertices, left - t, top - t, right + t, top, widget.outlineColor);
+        appendRect(widget.vertices, left - t, bottom, right + t, bottom + t, widget.outlineColor);
+        appendRect(widget.vertices, left - t, top, left, bottom, widget.outlineColor);
+        appendRect(widget.vertices, right, top, right + t, bottom, widget.outlineColor);
+    }
+
+    void buildSprite(Widget& widget) {
+        const sf::Sprite& sprite = *widget.sprite;
+        if (!sprite.getTexture()) return;
+        const sf::IntRect& rect = sprite.getTextureRect();
+        const sf::Transform& transform = sprite.getTransform();
+        float w = static_cast<float>(abs(rect.width));
+        float h = static_cast<float>(abs(rect.height));
+        float left = static_cast<float>(rect.left), top = static_cast<float>(rect.top);
+        float right = left + rect.width, bottom = top + rect.height;
+        const sf::Vector2f corners[4] = { transform.transformPoint(0, 0), transform.transformPoint(w, 0),
+            transform.transformPoint(w, h), transform.transformPoint(0, h) };
+        const sf::Vector2f uvs[4] = { { left, top }, { right, top }, { right, bottom }, { left, bottom } };
+        appendQuad(widget.vertices, corners, sprite.getColor(), uvs);
+        widget.texture = sprite.getTexture();
+    }
+
+    // Dirty widgets get new quads; then every visible widget's quads are
+    // gathered by texture, in order of first use
+    void rebuild() {
+        for (Widget& widget : widgets) {
+            if (!widget.dirty) continue;
+            widget.vertices.clear();
+            widget.texture = nullptr;
+            switch (widget.kind) {
+            case WidgetKind::Text: buildText(widget); break;
+            case WidgetKind::Box: buildBox(widget); break;
+            case WidgetKind::Sprite: buildSprite(widget); break;
             }
-            else {
-                sprite.setTextureRect(sf::IntRect(static_cast<int>(currentFrame * frameWidth), 0,
-                    static_cast<int>(frameWidth), sprite.getTexture()->getSize().y));
+            widget.dirty = false;
+            widgetBuilds++;
+        }
+
+        for (Batch& batch : batches) batch.vertices.clear();
+        for (const Widget& widget : widgets) {
+            if (!widget.visible || widget.vertices.empty()) continue;
+            auto batch = find_if(batches.begin(), batches.end(),
+                [&](const Batch& b) { return b.texture == widget.texture; });
+            if (batch == batches.end()) {
+                batches.push_back({ widget.texture, {} });
+                batch = batches.end() - 1;
             }
+            batch->vertices.insert(batch->vertices.end(), widget.vertices.begin(), widget.vertices.end());
+        }
+        dirty = false;
+    }
+
+    WidgetId add(Widget widget) {
+        widgets.push_back(move(widget));
+        dirty = true;
+        return widgets.size() - 1;
+    }
+
+public:
+    void setFont(const sf::Font& gameFont) {
+        font = &gameFont;
+        invalidate();
+    }
+
+    WidgetId addText(const string& text, unsigned characterSize, sf::Color color, float x, float y) {
+        Widget widget;
+        widget.kind = WidgetKind::Text;
+        widget.text = text;
+        widget.characterSize = characterSize;
+        widget.color = color;
+        widget.position = sf::Vector2f(x, y);
+        return add(move(widget));
+    }
+
+    WidgetId addBox(float x, float y, float width, float height, sf::Color fill,
+        sf::Color outline, float outlineThickness) {
+        Widget widget;
+        widget.kind = WidgetKind::Box;
+        widget.color = fill;
+        widget.position = sf::Vector2f(x, y);
+        widget.size = sf::Vector2f(width, height);
+        widget.outlineColor = outline;
+        widget.outlineThickness = outlineThickness;
+        return add(move(widget));
+    }
+
+    // The sprite is read again whenever the widget is rebuilt
+    WidgetId addSprite(const sf::Sprite& sprite) {
+        Widget widget;
+        widget.kind = WidgetKind::Sprite;
+        widget.sprite = &sprite;
+        return add(move(widget));
+    }
+
+    void setText(WidgetId id, const string& text) {
+        Widget& widget = widgets[id];
+        if (widget.text == text) return;
+        widget.text = text;
+        widget.dirty = dirty = true;
+    }
+
+    void setColor(WidgetId id, sf::Color color) {
+        Widget& widget = widgets[id];
+        if (widget.color == color) return;
+        widget.color = color;
+        widget.dirty = dirty = true;
+    }
+
+    void setVisible(WidgetId id, bool visible) {
+        Widget& widget = widgets[id];
+        if (widget.visible == visible) return;
+        widget.visible = visible;
+        dirty = true;   // regathered, not rebuilt
+    }
+
+    // Every widget, e.g. once the font or a sprite's texture has loaded
+    void invalidate() {
+        for (Widget& widget : widgets) widget.dirty = true;
+        dirty = true;
+    }
+
+    bool isDirty() const { return dirty; }
+
+    void draw(sf::RenderTarget& target) {
+        if (dirty) rebuild();
+        for (const Batch& batch : batches) {
+            if (batch.vertices.empty()) continue;
+            target.draw(batch.vertices.data(), batch.vertices.size(), sf::Triangles, sf::RenderStates(batch.texture));
+            countDrawCalls();
         }
     }
+
+    // Widgets whose quads were regenerated, for checking that a still screen stays cached
+    uint64_t getWidgetBuildCount() const { return widgetBuilds; }
 };
 
 // ============================================================================
@@ -1408,13 +5060,76 @@ private:
     unique_ptr<Spaceship> player;
     unique_ptr<FinalBoss> boss;
     vector<unique_ptr<Enemy>> enemies;
-    vector<unique_ptr<Bullet>> bullets;
-    vector<unique_ptr<PowerUp>> powerUps;
-    vector<unique_ptr<Explosion>> explosions;
+    BulletPool bullets;
+    EntityPool<PowerUp> powerUps{ MAX_POWERUPS };
+    EntityPool<Explosion> explosions{ MAX_EXPLOSIONS };
 
     // Visual effects
     unique_ptr<Starfield> starfield;
     ParticleSystem particles;
+    SpriteBatch spriteBatch;
+
+    // Headless: no loader, no snapshots; the caller drives stepSimulation()
+    bool headless;
+
+    // Simulation/render split: the simulation publishes a RenderSnapshot after
+    // its ticks; gameplay is drawn from the newest one. With the simulation
+    // thread running, every other access to this object holds stateMutex.
+    SnapshotBuffer snapshots;
+    mutex stateMutex;
+    thread simulationThread;
+    atomic<bool> simulationRunning;
+    uint64_t simulationTicks;
+    uint64_t framesDrawn;
+
+    // Per-subsystem timing of gameplay ticks, off unless a benchmark or the
+    // overlay asks: the last tick, and every tick since the last snapshot
+    bool tickTimingEnabled;
+    TickTimings tickTimings;
+    TickTimings snapshotTimings;
+    chrono::steady_clock::time_point lapStart;
+
+#ifdef PERF_OVERLAY
+    PerfOverlay perfOverlay;
+    double hudMs = 0;                                   // drawHud, last frame
+    bool perfOverlayVisible = false;
+    const RenderSnapshot* overlaySnapshot = nullptr;   // drawn this frame, if any
+    const RenderSnapshot* pausedSnapshot = nullptr;    // frozen under the Pause layer
+    uint64_t overlayFreshReads = 0;
+    double inputMs = 0;
+    double drawMs = 0;
+    double frameMs = 0;
+    chrono::steady_clock::time_point lastFrameAt = chrono::steady_clock::now();
+#endif
+
+    RetainedHud retainedHud;
+    PrimitiveBatch primitives;   // main thread, flushed within each draw function
+
+    // Screens that hold still are composited from cached layers
+    LayerStack<GameState> menuLayers;
+    LayerStack<GameState> highScoreLayers;
+    LayerStack<GameState> pauseLayers;
+    GameScreen lastDrawnScreen = GameScreen::Intro;
+
+    // Retained screens (see UiScreen), laid out once by buildUi()
+    UiScreen menuUi, instructionsUi, highScoreUi, gameOverUi, victoryUi;
+    UiScreen::WidgetId soundOption = 0, difficultyLabel = 0;
+    array<UiScreen::WidgetId, MAX_HIGH_SCORES> highScoreEntries = {};
+    UiScreen::WidgetId gameOverScore = 0, gameOverName = 0, victoryScore = 0, victoryName = 0;
+
+    // Time in draw() per screen, for the [PERF] line on exit
+    static const int SCREEN_COUNT = static_cast<int>(GameScreen::BossWarning) + 1;
+    array<double, SCREEN_COUNT> screenDrawMs = {};
+    array<uint64_t, SCREEN_COUNT> screenDrawFrames = {};
+
+    string profilePath = PROFILE_DEFAULT_PATH;   // where F4 writes its trace
+    Profiler::Capture pendingTrace;               // taken by F4, written by writePendingTrace()
+    bool tracePending = false;
+
+    // Collision broadphase (storage reused across frames)
+    SpatialGrid enemyGrid;
+    vector<int> enemyBulletIds;
+    vector<int> collisionCandidates;
 
     // Backgrounds
     sf::Sprite gameBackground;
@@ -1436,9 +5151,13 @@ private:
     vector<string> introTexts;
     int currentIntroText;
 
-    // Timing
+    // Timing: the simulation advances in fixed ticks of tickSeconds (deltaTime
+    // during a tick); slowTimeMultiplier scales how fast game time accumulates
     sf::Clock gameClock;
     float deltaTime;
+    float tickSeconds;
+    float tickAccumulator;
+    float renderAlpha;
     float slowTimeMultiplier;
     float slowTimeTimer;
 
@@ -1447,7 +5166,11 @@ private:
     float shakeTimer;
     Vector2 shakeOffset;
 
+    // Startup loading (declared before the font, which may read from its mapped bundle)
+    AssetLoader assetLoader;
+
     // UI
+    vector<char> fontData;        // backing store for gameFont, must outlive it
     sf::Font gameFont;
     bool fontLoaded;
 
@@ -1460,108 +5183,553 @@ private:
     float difficulty;
 
     // Input tracking
+    PlayerInput input;
     bool mKeyPressed;
     bool pKeyPressed;
 
+    // Input recording and replay (see REPLAY); never both at once
+    unique_ptr<ReplayWriter> recorder;
+    bool recordingGame;
+    unique_ptr<ReplayReader> replay;
+    uint64_t replayTicks;
+    uint64_t replayChecks;
+    uint64_t replayMismatches;
+    int replayGames;
+
+    // Screen transitions: music prefetch and worst-frame tracking
+    static const int TRANSITION_WATCH_FRAMES = 30;
+    GameScreen lastScreen;
+    string transitionLabel;
+    int transitionFramesLeft;
+    float transitionWorstMs;
+
+    void reportTransition() {
+        cout << "[PERF] " << transitionLabel << ": worst frame " << transitionWorstMs << " ms" << endl;
+    }
+
+    void onScreenChanged(GameScreen from, GameScreen to) {
+        ProfileZone zone("GameState::onScreenChanged");
+        // Open the track the next screen is likely to want while this one runs
+        SoundManager& sm = SoundManager::getInstance();
+        switch (to) {
+        case GameScreen::Menu:
+        case GameScreen::GameOver:
+        case GameScreen::Victory:
+            sm.prefetchMusic("assets/game_music.wav");
+            break;
+        case GameScreen::BossWarning:
+            sm.prefetchMusic("assets/boss_music.wav");
+            break;
+        default:
+            break;
+        }
+
+        if (transitionFramesLeft > 0) reportTransition();
+        transitionLabel = string(screenName(from)) + " -> " + screenName(to);
+        transitionFramesLeft = TRANSITION_WATCH_FRAMES;
+        transitionWorstMs = 0;
+    }
+
+    // frameMs is the previous frame, i.e. the one in which a transition happened
+    void trackTransitions(float frameMs) {
+        if (currentScreen != lastScreen) {
+            onScreenChanged(lastScreen, currentScreen);
+            lastScreen = currentScreen;
+        }
+        if (transitionFramesLeft > 0) {
+            transitionWorstMs = max(transitionWorstMs, frameMs);
+            if (--transitionFramesLeft == 0) reportTransition();
+        }
+    }
+
+    // Milliseconds since the previous lap, when tick timing is on
+    double lap() {
+        if (!tickTimingEnabled) return 0;
+        auto now = chrono::steady_clock::now();
+        double ms = chrono::duration<double, milli>(now - lapStart).count();
+        lapStart = now;
+        return ms;
+    }
+
+    bool gameInProgress() const {
+        return currentScreen == GameScreen::Gameplay || currentScreen == GameScreen::Pause ||
+            currentScreen == GameScreen::BossWarning;
+    }
+
+    // Hash of the gameplay state a replay has to reproduce. Particles and the
+    // screen are left out: they only change what is drawn.
+    uint32_t stateChecksum() const {
+        uint32_t hash = 2166136261u;   // FNV-1a
+        auto mix = [&hash](const void* data, size_t size) {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 16777619u;
+        };
+        auto mixObject = [&mix](const GameObject& object) {
+            Vector2 p = object.getPosition();
+            float health = object.getHealth();
+            mix(&p.x, sizeof(p.x));
+            mix(&p.y, sizeof(p.y));
+            mix(&health, sizeof(health));
+        };
+
+        int score = player->getScore(), lives = player->getLives(), bossLevel = isBossLevel ? 1 : 0;
+        mix(&currentLevel, sizeof(currentLevel));
+        mix(&currentPhase, sizeof(currentPhase));
+        mix(&phaseTimer, sizeof(phaseTimer));
+        mix(&bossLevel, sizeof(bossLevel));
+        mix(&score, sizeof(score));
+        mix(&lives, sizeof(lives));
+        mixObject(*player);
+        for (const auto& enemy : enemies) mixObject(*enemy);
+        for (const Bullet& bullet : bullets) mixObject(bullet);
+        for (const PowerUp& powerUp : powerUps) mixObject(powerUp);
+        if (boss) mixObject(*boss);
+        return hash;
+    }
+
+    void endRecordedGame() {
+        recorder->checkpoint(stateChecksum());
+        recordingGame = false;
+    }
+
+    // Called before each tick of a replay: applies the recorded input and any
+    // game starts and state checks that come before it
+    void feedReplay() {
+        while (true) {
+            switch (replay->next()) {
+            case ReplayReader::Step::Game:
+                difficulty = replay->getDifficulty();
+                startGame(replay->getSeed());
+                replayGames++;
+                break;
+            case ReplayReader::Step::Check:
+                replayChecks++;
+                if (replay->getChecksum() != stateChecksum() && replayMismatches++ == 0) {
+                    cerr << "[FAIL] Replay diverged by tick " << replayTicks << " (game " << replayGames << ")" << endl;
+                }
+                break;
+            case ReplayReader::Step::End:
+                // The session ends here; a game cut off mid-play goes no further
+                if (gameInProgress()) currentScreen = GameScreen::Menu;
+                finishReplay();
+                return;
+            case ReplayReader::Step::Tick: {
+                uint8_t bits = replay->getBits();
+                input = unpackInput(bits);
+                bool paused = (bits & INPUT_PAUSED) != 0;
+                if (paused && currentScreen == GameScreen::Gameplay) currentScreen = GameScreen::Pause;
+                else if (!paused && currentScreen == GameScreen::Pause) currentScreen = GameScreen::Gameplay;
+                replayTicks++;
+                return;
+            }
+            }
+        }
+    }
+
+    void finishReplay() {
+        if (replayMismatches == 0) {
+            cout << "[OK] Replay matched: " << replayChecks << " state checks" << endl;
+        }
+        else {
+            cerr << "[FAIL] Replay diverged: " << replayMismatches << " of " << replayChecks << " state checks differ" << endl;
+        }
+        cout << "  " << replayGames << " games, " << replayTicks << " ticks, final score " << player->getScore() << endl;
+        replay.reset();
+    }
+
 public:
-    GameState() : currentScreen(GameScreen::Intro), currentLevel(1), currentPhase(1),
+    explicit GameState(bool headlessMode = false) : headless(headlessMode),
+        simulationRunning(false), simulationTicks(0), framesDrawn(0), tickTimingEnabled(false),
+        currentScreen(GameScreen::Intro), currentLevel(1), currentPhase(1),
         phaseTimer(30.0f), isBossLevel(false), introTimer(0), introFrame(0),
-        currentIntroText(0), deltaTime(0), slowTimeMultiplier(1.0f), slowTimeTimer(0),
+        currentIntroText(0), deltaTime(0), tickSeconds(1.0f / SIMULATION_TICK_RATE), tickAccumulator(0),
+        renderAlpha(1.0f), slowTimeMultiplier(1.0f), slowTimeTimer(0),
         shakeIntensity(0), shakeTimer(0), fontLoaded(false), soundEnabled(true),
-        difficulty(1.0f), mKeyPressed(false), pKeyPressed(false) {
+        difficulty(1.0f), mKeyPressed(false), pKeyPressed(false), recordingGame(false),
+        replayTicks(0), replayChecks(0), replayMismatches(0), replayGames(0), lastScreen(GameScreen::Intro),
+        transitionFramesLeft(0), transitionWorstMs(0) {
+
+        RandomGenerator::seed();
+
+        // So spawning and checkCollisions() don't grow them mid-game
+        enemies.reserve(ENEMY_RESERVE);
+        enemyGrid.reserve(ENEMY_RESERVE);
+        collisionCandidates.reserve(ENEMY_RESERVE);
+        enemyBulletIds.reserve(MAX_BULLETS);
+
+        if (headless) {
+            // Nothing is loaded; textures resolve to their recorded sizes only
+            finishLoading();
+        }
+        else {
+            // Assets decode in the background; finishLoading() runs once they are in
+            assetLoader.start();
+            SoundManager::getInstance().prefetchMusic("assets/menu_music.wav");
+        }
+
+        starfield = make_unique<Starfield>(250);
+
+        // Setup intro texts
+        introTexts = {
+            "In the year 2387...",
+            "Humanity spread across the galaxy,",
+            "seeking new worlds to colonize.",
+            "But something ancient awakened...",
+            "EMPEROR DESTRUCTON",
+            "A being of pure cosmic destruction.",
+            "Now only one pilot stands in his way...",
+            "YOU."
+        };
+
+        // Back to front. A background is one sprite, no dearer than its cache
+        // would be, and the starfield moves; the rest is redrawn when invalidated
+        menuLayers.add("background", LayerKind::Dynamic, &GameState::drawMenuBackground);
+        menuLayers.add("stars", LayerKind::Dynamic, &GameState::drawStars);
+        menuLayers.add("options", LayerKind::Static, &GameState::drawMenuOptions);
+        highScoreLayers.add("background", LayerKind::Dynamic, &GameState::drawMenuBackground);
+        highScoreLayers.add("stars", LayerKind::Dynamic, &GameState::drawStars);
+        highScoreLayers.add("table", LayerKind::Static, &GameState::drawHighScoreTable);
+        pauseLayers.add("frozen", LayerKind::Static, &GameState::drawPausedFrame);
 
-        RandomGenerator::seed();
+        loadHighScores();
+        buildUi();
+        retainedHud.setFont(gameFont);
+#ifdef PERF_OVERLAY
+        perfOverlay.setFont(gameFont);
+#endif
+    }
 
-        // Load all resources
-        TextureManager::getInstance().loadAllTextures();
-        SoundManager::getInstance().loadAllSounds();
-
-        // Load font
-        fontLoaded = gameFont.loadFromFile("assets/font.otf");
-        if (!fontLoaded) {
-            // Try system fonts
-            vector<string> fontPaths = {
-                "C:/Windows/Fonts/arial.ttf",
-                "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
-                "/System/Library/Fonts/Helvetica.ttc"
-            };
-            for (const auto& path : fontPaths) {
-                if (gameFont.loadFromFile(path)) {
-                    fontLoaded = true;
-                    break;
-                }
-            }
-        }
+    // Everything that needs textures, once the loader has uploaded them
+    void finishLoading() {
+        ProfileZone zone("GameState::finishLoading");
+        bullets.setupStyles();
 
         // Setup backgrounds
         TextureManager& tm = TextureManager::getInstance();
-        if (tm.hasTexture("background")) {
-            gameBackground.setTexture(tm.getTexture("background"));
+        if (tm.hasTexture(TextureId::Background)) {
+            gameBackground.setTexture(tm.getTexture(TextureId::Background));
             float scaleX = SCREEN_WIDTH / gameBackground.getTexture()->getSize().x;
             float scaleY = SCREEN_HEIGHT / gameBackground.getTexture()->getSize().y;
             gameBackground.setScale(scaleX, scaleY);
         }
-        if (tm.hasTexture("menu_background")) {
-            menuBackground.setTexture(tm.getTexture("menu_background"));
+        if (tm.hasTexture(TextureId::MenuBackground)) {
+            menuBackground.setTexture(tm.getTexture(TextureId::MenuBackground));
             float scaleX = SCREEN_WIDTH / menuBackground.getTexture()->getSize().x;
             float scaleY = SCREEN_HEIGHT / menuBackground.getTexture()->getSize().y;
             menuBackground.setScale(scaleX, scaleY);
         }
-        if (tm.hasTexture("boss_background")) {
-            bossBackground.setTexture(tm.getTexture("boss_background"));
+        if (tm.hasTexture(TextureId::BossBackground)) {
+            bossBackground.setTexture(tm.getTexture(TextureId::BossBackground));
             float scaleX = SCREEN_WIDTH / bossBackground.getTexture()->getSize().x;
             float scaleY = SCREEN_HEIGHT / bossBackground.getTexture()->getSize().y;
             bossBackground.setScale(scaleX, scaleY);
         }
-        if (tm.hasTexture("intro_video")) {
-            introSprite.setTexture(tm.getTexture("intro_video"));
+        if (tm.hasTexture(TextureId::IntroVideo)) {
+            introSprite.setTexture(tm.getTexture(TextureId::IntroVideo));
             float scaleX = SCREEN_WIDTH / introSprite.getTexture()->getSize().x;
             float scaleY = SCREEN_HEIGHT / introSprite.getTexture()->getSize().y;
             introSprite.setScale(scaleX, scaleY);
         }
-        if (tm.hasTexture("logo")) {
-            logoSprite.setTexture(tm.getTexture("logo"));
+        if (tm.hasTexture(TextureId::Logo)) {
+            logoSprite.setTexture(tm.getTexture(TextureId::Logo));
             logoSprite.setOrigin(logoSprite.getTexture()->getSize().x / 2.0f,
                 logoSprite.getTexture()->getSize().y / 2.0f);
             logoSprite.setPosition(SCREEN_WIDTH / 2, 150);
         }
+        invalidateLayers();
+        for (UiScreen* ui : { &menuUi, &instructionsUi, &highScoreUi, &gameOverUi, &victoryUi }) ui->invalidate();
 
-        starfield = make_unique<Starfield>(250);
         player = make_unique<Spaceship>();
+    }
 
-        // Setup intro texts
-        introTexts = {
-            "In the year 2387...",
-            "Humanity spread across the galaxy,",
-            "seeking new worlds to colonize.",
-            "But something ancient awakened...",
-            "EMPEROR DESTRUCTON",
-            "A being of pure cosmic destruction.",
-            "Now only one pilot stands in his way...",
-            "YOU."
+    void invalidateLayers() {
+        menuLayers.invalidate();
+        highScoreLayers.invalidate();
+        pauseLayers.invalidate();
+    }
+
+    // Layout for the retained screens; the values that change are filled in
+    // by the refresh functions below
+    void buildUi() {
+        menuUi.addSprite(logoSprite);
+        const char* const menuKeys[] = { "ENTER", "I", "H", "S", "ESC" };
+        const char* const menuOptions[] = { "Start Game", "Instructions", "High Scores", "", "Exit Game" };
+        for (int i = 0; i < 5; i++) {
+            float y = 300.0f + i * 60;
+            menuUi.addBox(SCREEN_WIDTH / 2 - 180, y, 60, 40, sf::Color(30, 30, 60), sf::Color(100, 150, 255), 2);
+            menuUi.addText(menuKeys[i], 16, sf::Color(100, 200, 255), SCREEN_WIDTH / 2 - 170, y + 10);
+            UiScreen::WidgetId option = menuUi.addText(menuOptions[i], 24, sf::Color::White, SCREEN_WIDTH / 2 - 100, y + 8);
+            if (i == 3) soundOption = option;
+        }
+        difficultyLabel = menuUi.addText("", 18, sf::Color(200, 200, 100), SCREEN_WIDTH / 2 - 140, SCREEN_HEIGHT - 80);
+
+        instructionsUi.addText("INSTRUCTIONS", 48, sf::Color(100, 200, 255), SCREEN_WIDTH / 2 - 180, 40);
+        const char* const instructions[] = {
+            "CONTROLS:",
+            "  Arrow Keys / WASD - Move spaceship",
+            "  SPACE - Fire weapons",
+            "  P - Pause game",
+            "  M - Toggle sound",
+            "  ESC - Return to menu",
+            "",
+            "POWER-UPS:",
+            "  Yellow - Increase weapon power",
+            "  Orange - Faster fire rate",
+            "  Blue - Shield protection",
+            "  Green - Extra life + heal",
+            "  Purple - Multi-shot upgrade",
+            "  Red - Temporary invincibility",
+            "  Dark Purple - Screen nuke",
+            "  Cyan - Slow time",
+            "",
+            "OBJECTIVE:",
+            "  Survive 2 levels with 2 phases each",
+            "  Then defeat EMPEROR DESTRUCTON!",
+            "",
+            "Press ESC to return"
         };
+        float y = 110;
+        for (const char* line : instructions) {
+            instructionsUi.addText(line, 18, strchr(line, ':') ? sf::Color(255, 200, 100) : sf::Color::White, 100, y);
+            y += 25;
+        }
 
-        loadHighScores();
+        highScoreUi.addText("HIGH SCORES", 48, sf::Color(255, 200, 100), SCREEN_WIDTH / 2 - 180, 50);
+        for (int i = 0; i < MAX_HIGH_SCORES; i++) {
+            highScoreEntries[i] = highScoreUi.addText("", 24, i < 3 ? sf::Color(255, 200, 0) : sf::Color::White,
+                SCREEN_WIDTH / 2 - 200, 140.0f + i * 45);
+        }
+        highScoreUi.addText("Press ESC to return", 20, sf::Color(150, 150, 200), SCREEN_WIDTH / 2 - 120, SCREEN_HEIGHT - 60);
+
+        gameOverUi.addText("GAME OVER", 72, sf::Color(255, 50, 50), SCREEN_WIDTH / 2 - 250, 120);
+        gameOverScore = gameOverUi.addText("", 36, sf::Color(255, 200, 100), SCREEN_WIDTH / 2 - 180, 240);
+        gameOverUi.addText("Enter your name:", 24, sf::Color::White, SCREEN_WIDTH / 2 - 120, 340);
+        gameOverName = gameOverUi.addText("", 28, sf::Color(100, 255, 100), SCREEN_WIDTH / 2 - 100, 390);
+        gameOverUi.addText("Press ENTER to submit", 18, sf::Color(150, 150, 200), SCREEN_WIDTH / 2 - 120, 460);
+
+        victoryUi.addText("VICTORY!", 80, sf::Color(100, 255, 100), SCREEN_WIDTH / 2 - 200, 100);
+        victoryUi.addText("Emperor Destructon has been defeated!", 28, sf::Color(200, 255, 200), SCREEN_WIDTH / 2 - 260, 220);
+        victoryScore = victoryUi.addText("", 36, sf::Color(255, 220, 100), SCREEN_WIDTH / 2 - 180, 300);
+        victoryUi.addText("Enter your name for the Hall of Fame:", 22, sf::Color::White, SCREEN_WIDTH / 2 - 200, 400);
+        victoryName = victoryUi.addText("", 28, sf::Color(100, 255, 100), SCREEN_WIDTH / 2 - 100, 450);
+        victoryUi.addText("Press ENTER to submit", 18, sf::Color(150, 200, 150), SCREEN_WIDTH / 2 - 120, 520);
+
+        for (UiScreen* ui : { &menuUi, &instructionsUi, &highScoreUi, &gameOverUi, &victoryUi }) ui->setFont(gameFont);
+        refreshMenuUi();
+        refreshHighScoreUi();
+    }
+
+    // Each only dirties the widgets whose text actually changed
+    void refreshMenuUi() {
+        menuUi.setText(soundOption, string("Toggle Sound: ") + (soundEnabled ? "ON" : "OFF"));
+        const char* level = difficulty < 1.0f ? "EASY" : (difficulty < 1.3f ? "NORMAL" : "HARD");
+        menuUi.setText(difficultyLabel, string("Difficulty: ") + level + " (D to change)");
+    }
+
+    void refreshHighScoreUi() {
+        for (size_t i = 0; i < highScoreEntries.size(); i++) {
+            bool shown = i < highScores.size();
+            if (shown) {
+                highScoreUi.setText(highScoreEntries[i], to_string(i + 1) + ". " + highScores[i].first + " - " +
+                    to_string(highScores[i].second));
+            }
+            highScoreUi.setVisible(highScoreEntries[i], shown);
+        }
+    }
+
+    void refreshEndScreenUi() {
+        string score = "Final Score: " + to_string(player ? player->getScore() : 0);
+        gameOverUi.setText(gameOverScore, score);
+        victoryUi.setText(victoryScore, score);
+        refreshNameEntry();
+    }
+
+    void refreshNameEntry() {
+        gameOverUi.setText(gameOverName, playerName + "_");
+        victoryUi.setText(victoryName, playerName + "_");
+    }
+
+    bool assetsReady() const { return assetLoader.isComplete(); }
+
+    GameScreen getScreen() const { return currentScreen; }
+    void setInput(const PlayerInput& held) { input = held; }
+
+    EntityCounts countEntities() const {
+        EntityCounts counts;
+        counts.enemies = enemies.size() + (boss && boss->isActive() ? 1 : 0);
+        counts.bullets = bullets.size();
+        counts.powerUps = powerUps.size();
+        counts.explosions = explosions.size();
+        counts.particles = particles.getCount() + (player ? player->getThrustParticleCount() : 0);
+        return counts;
+    }
+
+    uint64_t getSimulationTicks() const { return simulationTicks; }
+    uint64_t getFramesDrawn() const { return framesDrawn; }
+
+    // Mean CPU time per frame spent drawing each screen that was shown
+    void printScreenDrawTimes() const {
+        cout << "[PERF] Draw time per frame:";
+        const char* separator = " ";
+        for (int i = 0; i < SCREEN_COUNT; i++) {
+            if (!screenDrawFrames[i]) continue;
+            cout << separator << screenName(static_cast<GameScreen>(i)) << " "
+                << screenDrawMs[i] / screenDrawFrames[i] << " ms";
+            separator = ", ";
+        }
+        cout << " (static layer renders: " << menuLayers.getRebuildCount() + highScoreLayers.getRebuildCount()
+            + pauseLayers.getRebuildCount() << ")" << endl;
+    }
+    const SnapshotBuffer& getSnapshotBuffer() const { return snapshots; }
+
+    void setProfilePath(const string& path) { profilePath = path; }
+
+    // Main thread, without the state lock: the simulation keeps running while the file is written
+    void writePendingTrace() {
+        if (!tracePending) return;
+        pendingTrace.write(profilePath);
+        pendingTrace = Profiler::Capture();
+        tracePending = false;
+    }
+
+    void setTickRate(float ticksPerSecond) {
+        tickSeconds = 1.0f / max(ticksPerSecond, 1.0f);
+        tickAccumulator = 0;
+    }
+
+    ~GameState() {
+        stopSimulationThread();
+        stopRecording();
+    }
+
+    // Records every game from here on; call after setTickRate()
+    bool startRecording(const string& path) {
+        recorder = make_unique<ReplayWriter>();
+        if (!recorder->open(path, 1.0f / tickSeconds)) {
+            recorder.reset();
+            return false;
+        }
+        return true;
+    }
+
+    void stopRecording() {
+        if (!recorder) return;
+        if (recordingGame) endRecordedGame();
+        recorder->close();
+        cout << "Replay: " << recorder->getGamesRecorded() << " games, " << recorder->getTicksRecorded()
+            << " ticks in " << recorder->getBytesEncoded() << " bytes" << endl;
+        recorder.reset();
     }
 
+    // Plays a recording in place of the keyboard until it ends
+    bool startReplay(const string& path) {
+        replay = make_unique<ReplayReader>();
+        if (!replay->open(path)) {
+            replay.reset();
+            return false;
+        }
+        setTickRate(replay->getTickRate());
+        return true;
+    }
+
+    bool isReplaying() const { return replay != nullptr; }
+    uint64_t getReplayMismatches() const { return replayMismatches; }
+
+    // Held by the main thread around event handling and input
+    unique_lock<mutex> lockState() { return unique_lock<mutex>(stateMutex); }
+
+    void startSimulationThread() {
+        if (simulationThread.joinable()) return;
+        simulationRunning = true;
+        gameClock.restart();
+        simulationThread = thread(&GameState::simulationLoop, this);
+    }
+
+    void stopSimulationThread() {
+        if (!simulationThread.joinable()) return;
+        simulationRunning = false;
+        simulationThread.join();
+    }
+
+    void simulationLoop() {
+        Profiler::setThreadName("simulation");
+        while (simulationRunning.load(memory_order_relaxed)) {
+            float secondsToNextTick;
+            {
+                lock_guard<mutex> lock(stateMutex);
+                advance();
+                secondsToNextTick = (tickSeconds - tickAccumulator) / slowTimeMultiplier;
+            }
+            this_thread::sleep_for(chrono::duration<float>(max(secondsToNextTick, 0.0f)));
+        }
+    }
+
+    // Main thread, once per rendered frame, with the state lock held
     void update() {
-        deltaTime = gameClock.restart().asSeconds();
-        deltaTime = min(deltaTime, 0.05f) * slowTimeMultiplier;
+        ProfileZone zone("GameState::update");
+        // Textures are uploaded here, so loading stays on the window's thread
+        if (!assetsReady() && assetLoader.pump(gameFont, fontData, fontLoaded)) {
+            finishLoading();
+        }
+
+        if (!simulationThread.joinable()) advance();
+    }
 
-        // Update screen shake
+    // Runs the simulation up to the current time and publishes a snapshot;
+    // on the simulation thread when there is one, otherwise from update()
+    void advance() {
+        ProfileZone zone("GameState::advance");
+        float frameSeconds = gameClock.restart().asSeconds();
+        trackTransitions(frameSeconds * 1000.0f);
+
+        // Screen shake is presentation only, so it follows the rendered frame
+        float shakeDt = min(frameSeconds, 0.05f) * slowTimeMultiplier;
         if (shakeTimer > 0) {
-            shakeTimer -= deltaTime;
+            shakeTimer -= shakeDt;
             shakeOffset = Vector2(
-                RandomGenerator::range(-shakeIntensity, shakeIntensity),
-                RandomGenerator::range(-shakeIntensity, shakeIntensity)
+                RandomGenerator::cosmetic().range(-shakeIntensity, shakeIntensity),
+                RandomGenerator::cosmetic().range(-shakeIntensity, shakeIntensity)
             );
-            shakeIntensity *= 0.95f;
+            shakeIntensity *= pow(0.95f, shakeDt * TARGET_FPS);
         }
         else {
             shakeOffset = Vector2(0, 0);
         }
 
-        // Update slow time
+        // Run as many fixed ticks as the elapsed (time-scaled) time covers. A
+        // frame that would need more than MAX_SIMULATION_STEPS drops the rest,
+        // so a slow machine runs the game slower instead of falling further behind.
+        tickAccumulator += frameSeconds * slowTimeMultiplier;
+        int steps = 0;
+        while (tickAccumulator >= tickSeconds) {
+            if (steps == MAX_SIMULATION_STEPS) {
+                tickAccumulator = fmod(tickAccumulator, tickSeconds);
+                break;
+            }
+            stepSimulation();
+            tickAccumulator -= tickSeconds;
+            steps++;
+        }
+        renderAlpha = tickAccumulator / tickSeconds;
+        if (player) publishSnapshot();
+
+        SoundManager::getInstance().flushSounds();
+        SoundManager::getInstance().updateMusic(min(frameSeconds, 0.05f));
+    }
+
+    void stepSimulation() {
+        ProfileZone zone("GameState::stepSimulation");
+        // A replay supplies each tick's input, and starts its games itself
+        if (replay && player) feedReplay();
+
+        // The recording gets the input each tick of a game runs with
+        if (recordingGame && !gameInProgress()) endRecordedGame();   // left for the menu
+        if (recordingGame) recorder->recordTick(packInput(input, currentScreen == GameScreen::Pause));
+
+        deltaTime = tickSeconds;
+        simulationTicks++;
+
+        // Slow time runs out in real time, not game time
         if (slowTimeTimer > 0) {
             slowTimeTimer -= deltaTime / slowTimeMultiplier;
             if (slowTimeTimer <= 0) slowTimeMultiplier = 1.0f;
@@ -1575,6 +5743,7 @@ public:
             starfield->update(deltaTime);
             break;
         case GameScreen::Gameplay:
+            applyInput();
             updateGameplay();
             break;
         case GameScreen::BossWarning:
@@ -1584,11 +5753,65 @@ public:
             starfield->update(deltaTime);
             break;
         }
+
+        if (recordingGame) {
+            if (!gameInProgress()) endRecordedGame();
+            else if (recorder->checkpointDue()) recorder->checkpoint(stateChecksum());
+        }
+    }
+
+    void publishSnapshot() {
+        ProfileZone zone("GameState::publishSnapshot");
+        RenderSnapshot& snapshot = snapshots.beginWrite();
+        snapshot.tick = simulationTicks;
+        snapshot.alpha = renderAlpha;
+        snapshot.tickSeconds = tickSeconds / slowTimeMultiplier;
+        snapshot.capturedAt = chrono::steady_clock::now();
+
+        starfield->addTo(snapshot.stars);
+        particles.addTo(snapshot.particles);
+        for (const PowerUp& powerUp : powerUps) powerUp.capture(snapshot.powerUps);
+        for (auto& bullet : bullets) bullet.capture(snapshot.bullets);
+        for (auto& enemy : enemies) {
+            enemy->capture(snapshot.enemies);
+            enemy->captureOverlay(snapshot.healthBars);
+        }
+        for (const Explosion& explosion : explosions) explosion.capture(snapshot.explosions);
+        player->captureThrust(snapshot.thrust);
+        player->capture(snapshot.player);
+
+        snapshot.timings = snapshotTimings;
+        snapshot.counts = countEntities();
+        snapshotTimings = TickTimings();
+
+        HudValues& hud = snapshot.hud;
+        player->captureHud(hud);
+        hud.level = currentLevel;
+        hud.phase = currentPhase;
+        hud.enemyCount = enemies.size();
+        hud.slowTimeLeft = slowTimeTimer;
+        hud.bossLevel = isBossLevel;
+        hud.bossPresent = false;
+        if (isBossLevel && boss) {
+            boss->capture(snapshot.boss);
+            boss->captureShield(snapshot);
+            boss->captureHud(hud);
+        }
+
+        snapshots.publish();
     }
 
     void updateIntro() {
+        // Hold the text back until the font is in
+        if (!fontLoaded && !assetsReady()) return;
+
         introTimer += deltaTime;
 
+        // The last line stays on screen until loading has finished
+        if (!assetsReady() && currentIntroText + 1 >= static_cast<int>(introTexts.size())) {
+            introTimer = min(introTimer, 2.0f);
+        }
+
         // Change intro text every 2.5 seconds
         if (introTimer > 2.5f) {
             introTimer = 0;
@@ -1607,44 +5830,50 @@ public:
         if (phaseTimer <= 0) {
             currentScreen = GameScreen::Gameplay;
             isBossLevel = true;
-            boss = make_unique<FinalBoss>();
+            {
+                AllocationReason reason("spawn");
+                boss = make_unique<FinalBoss>();
+            }
             SoundManager::getInstance().playMusic("assets/boss_music.wav");
         }
     }
 
     void updateGameplay() {
+        ProfileZone zone("GameState::updateGameplay");
+        tickTimings = TickTimings();
+        lap();
         starfield->update(deltaTime);
         particles.update(deltaTime);
+        tickTimings.particles = lap();
 
         // Update player
-        player->update(deltaTime);
+        player->tick(deltaTime);
+        tickTimings.player = lap();
 
         // Update enemies or boss
         if (isBossLevel && boss) {
             boss->setPlayerPosition(player->getPosition());
-            boss->update(deltaTime);
+            boss->tick(deltaTime);
 
-            // Get boss bullets
-            auto bossBullets = boss->getAttackBullets();
-            for (auto& b : bossBullets) {
-                bullets.push_back(move(b));
-            }
+            // Boss bullets go straight into the pool
+            boss->fireAttackBullets(bullets);
 
             // Check if boss is defeated
             if (!boss->isActive()) {
                 currentScreen = GameScreen::Victory;
-                SoundManager::getInstance().playSound("victory");
+                SoundManager::getInstance().playSound(SoundId::Victory);
                 triggerScreenShake(20.0f, 1.0f);
             }
+            tickTimings.boss = lap();
         }
         else {
             // Update enemies
             for (auto& enemy : enemies) {
                 enemy->setPlayerPosition(player->getPosition());
-                enemy->update(deltaTime);
+                enemy->tick(deltaTime);
 
-                // Enemy firing
-                if (enemy->canFire() && RandomGenerator::range(0, 100) < 3) {
+                // Enemy firing; the odds were tuned per 60 Hz frame
+                if (enemy->canFire() && RandomGenerator::gameplay().nextFloat() < 0.03f * TARGET_FPS * deltaTime) {
                     fireEnemyBullet(enemy.get());
                     enemy->resetFireTimer();
                 }
@@ -1654,84 +5883,92 @@ public:
             if (enemies.empty() && phaseTimer <= 0) {
                 nextPhase();
             }
+            tickTimings.enemies = lap();
         }
 
         // Update bullets
         for (auto& bullet : bullets) {
-            bullet->update(deltaTime);
+            bullet.tick(deltaTime);
         }
+        tickTimings.bullets = lap();
 
         // Update power-ups
-        for (auto& powerUp : powerUps) {
-            powerUp->update(deltaTime);
+        for (PowerUp& powerUp : powerUps) {
+            powerUp.tick(deltaTime);
         }
 
         // Update explosions
-        for (auto& explosion : explosions) {
-            explosion->update(deltaTime);
+        for (Explosion& explosion : explosions) {
+            explosion.tick(deltaTime);
         }
 
+        tickTimings.other = lap();
+
         // Collision detection
         checkCollisions();
+        tickTimings.collision = lap();
 
         // Remove inactive objects
         removeInactiveObjects();
+        tickTimings.cleanup = lap();
 
         // Random power-up spawn
-        if (RandomGenerator::range(0, 1000) < 2) {
+        if (RandomGenerator::gameplay().nextFloat() < 0.002f * TARGET_FPS * deltaTime) {
             spawnPowerUp();
         }
 
         // Check game over
         if (player->getLives() <= 0 && player->getHealth() <= 0) {
             currentScreen = GameScreen::GameOver;
-            SoundManager::getInstance().playSound("game_over");
+            SoundManager::getInstance().playSound(SoundId::GameOver);
         }
 
         phaseTimer -= deltaTime;
+        tickTimings.other += lap();
+        snapshotTimings += tickTimings;
     }
 
     void firePlayerBullets() {
         if (!player->canFire()) return;
         player->resetFireTimer();
-        SoundManager::getInstance().playSound("shoot");
+        SoundManager::getInstance().playSound(SoundId::Shoot);
 
         int shots = player->getMultiShotLevel();
         int power = player->getPowerLevel();
 
         if (shots == 1) {
-            auto bullet = make_unique<Bullet>(true, 10 + power * 5);
+            Bullet* bullet = bullets.acquire(true, 10 + power * 5);
+            if (!bullet) return;
             bullet->setPosition(player->getPosition() + Vector2(0, -30));
             bullet->setVelocity(Vector2(0, -600));
-            bullets.push_back(move(bullet));
         }
         else if (shots == 2) {
             for (int i = -1; i <= 1; i += 2) {
-                auto bullet = make_unique<Bullet>(true, 10 + power * 4);
+                Bullet* bullet = bullets.acquire(true, 10 + power * 4);
+                if (!bullet) return;
                 bullet->setPosition(player->getPosition() + Vector2(i * 15, -25));
                 bullet->setVelocity(Vector2(0, -600));
-                bullets.push_back(move(bullet));
             }
         }
         else if (shots >= 3) {
-            auto center = make_unique<Bullet>(true, 10 + power * 5);
+            Bullet* center = bullets.acquire(true, 10 + power * 5);
+            if (!center) return;
             center->setPosition(player->getPosition() + Vector2(0, -30));
             center->setVelocity(Vector2(0, -600));
-            bullets.push_back(move(center));
 
             for (int i = -1; i <= 1; i += 2) {
-                auto side = make_unique<Bullet>(true, 8 + power * 3);
+                Bullet* side = bullets.acquire(true, 8 + power * 3);
+                if (!side) return;
                 side->setPosition(player->getPosition() + Vector2(i * 20, -20));
                 side->setVelocity(Vector2(i * 100, -550));
-                bullets.push_back(move(side));
             }
 
             if (shots >= 4) {
                 for (int i = -1; i <= 1; i += 2) {
-                    auto wide = make_unique<Bullet>(true, 6 + power * 2);
+                    Bullet* wide = bullets.acquire(true, 6 + power * 2);
+                    if (!wide) return;
                     wide->setPosition(player->getPosition() + Vector2(i * 25, -15));
                     wide->setVelocity(Vector2(i * 200, -500));
-                    bullets.push_back(move(wide));
                 }
             }
         }
@@ -1739,16 +5976,32 @@ public:
 
     void fireEnemyBullet(Enemy* enemy) {
         Vector2 dir = (player->getPosition() - enemy->getPosition()).normalized();
-        auto bullet = make_unique<Bullet>(false, 10);
+        Bullet* bullet = bullets.acquire(false, 10);
+        if (!bullet) return;
         bullet->setPosition(enemy->getPosition() + Vector2(0, 20));
         bullet->setVelocity(dir * 250.0f);
-        bullets.push_back(move(bullet));
     }
 
     void checkCollisions() {
-        // Player bullets vs enemies
-        for (auto& bullet : bullets) {
-            if (!bullet->isActive() || !bullet->isFromPlayer()) continue;
+        ProfileZone zone("GameState::checkCollisions");
+        // Rebuild the broadphase grid from the live enemies
+        enemyGrid.clear();
+        for (size_t i = 0; i < enemies.size(); i++) {
+            if (enemies[i]->isActive()) {
+                enemyGrid.insert(static_cast<int>(i), enemies[i]->getPosition(), enemies[i]->getBoundingRadius());
+            }
+        }
+        enemyGrid.build();
+
+        // Player bullets vs boss and enemies; enemy bullets are set aside for the player check
+        enemyBulletIds.clear();
+        for (size_t i = 0; i < bullets.size(); i++) {
+            Bullet* bullet = &bullets[i];
+            if (!bullet->isActive()) continue;
+            if (!bullet->isFromPlayer()) {
+                enemyBulletIds.push_back(static_cast<int>(i));
+                continue;
+            }
 
             // Check boss
             if (isBossLevel && boss && boss->isActive()) {
@@ -1760,10 +6013,13 @@ public:
                 }
             }
 
-            // Check enemies
-            for (auto& enemy : enemies) {
+            // Check enemies sharing a grid cell, in the same order as the full list
+            if (!bullet->isActive()) continue;
+            enemyGrid.query(bullet->getPosition(), bullet->getBoundingRadius(), collisionCandidates);
+            for (int e : collisionCandidates) {
+                Enemy* enemy = enemies[e].get();
                 if (!enemy->isActive()) continue;
-                if (bullet->checkCollision(enemy.get())) {
+                if (bullet->checkCollision(enemy)) {
                     enemy->takeDamage(bullet->getDamage());
                     bullet->setActive(false);
                     particles.emit(bullet->getPosition(), Vector2(0, 0), sf::Color::Yellow, 5, 0.3f);
@@ -1771,11 +6027,11 @@ public:
                     if (!enemy->isActive()) {
                         player->addScore(enemy->getScoreValue());
                         createExplosion(enemy->getPosition());
-                        SoundManager::getInstance().playSound("explosion");
+                        SoundManager::getInstance().playSound(SoundId::Explosion);
                         triggerScreenShake(5.0f, 0.15f);
 
                         // Chance to drop power-up
-                        if (RandomGenerator::range(0, 100) < 20) {
+                        if (RandomGenerator::gameplay().range(0, 100) < 20) {
                             spawnPowerUpAt(enemy->getPosition());
                         }
                     }
@@ -1784,8 +6040,8 @@ public:
         }
 
         // Enemy bullets vs player
-        for (auto& bullet : bullets) {
-            if (!bullet->isActive() || bullet->isFromPlayer()) continue;
+        for (int i : enemyBulletIds) {
+            Bullet* bullet = &bullets[i];
             if (bullet->checkCollision(player.get())) {
                 player->takeDamage(bullet->getDamage() * difficulty);
                 bullet->setActive(false);
@@ -1795,7 +6051,9 @@ public:
         }
 
         // Player vs enemies (collision damage)
-        for (auto& enemy : enemies) {
+        enemyGrid.query(player->getPosition(), player->getBoundingRadius(), collisionCandidates);
+        for (int i : collisionCandidates) {
+            Enemy* enemy = enemies[i].get();
             if (!enemy->isActive()) continue;
             if (enemy->checkCollision(player.get())) {
                 player->takeDamage(20 * difficulty);
@@ -1805,10 +6063,10 @@ public:
         }
 
         // Player vs power-ups
-        for (auto& powerUp : powerUps) {
-            if (!powerUp->isActive()) continue;
-            if (powerUp->checkCollision(player.get())) {
-                PowerUpType type = powerUp->getType();
+        for (PowerUp& powerUp : powerUps) {
+            if (!powerUp.isActive()) continue;
+            if (powerUp.checkCollision(player.get())) {
+                PowerUpType type = powerUp.getType();
 
                 if (type == PowerUpType::Nuke) {
                     // Destroy all enemies
@@ -1820,7 +6078,7 @@ public:
                         }
                     }
                     triggerScreenShake(15.0f, 0.5f);
-                    SoundManager::getInstance().playSound("explosion");
+                    SoundManager::getInstance().playSound(SoundId::Explosion);
                 }
                 else if (type == PowerUpType::Slow) {
                     slowTimeMultiplier = 0.4f;
@@ -1830,7 +6088,7 @@ public:
                     player->applyPowerUp(type);
                 }
 
-                powerUp->setActive(false);
+                powerUp.setActive(false);
                 particles.emit(player->getPosition(), Vector2(0, 0), sf::Color::Cyan, 15, 0.5f, 4.0f);
             }
         }
@@ -1842,35 +6100,31 @@ public:
         }
     }
 
+    // Pooled like bullets; a full pool drops the new one
     void createExplosion(const Vector2& pos, float scale = 1.0f) {
-        auto explosion = make_unique<Explosion>(pos, scale);
-        explosions.push_back(move(explosion));
+        explosions.acquire(pos, scale);
         particles.emitExplosion(pos, 15, 4.0f);
     }
 
     void spawnPowerUp() {
-        PowerUpType type = static_cast<PowerUpType>(RandomGenerator::range(0, 7));
-        auto powerUp = make_unique<PowerUp>(type);
-        powerUp->setPosition(Vector2(RandomGenerator::range(50.0f, SCREEN_WIDTH - 50.0f), -30));
-        powerUps.push_back(move(powerUp));
+        PowerUpType type = static_cast<PowerUpType>(RandomGenerator::gameplay().range(0, 7));
+        PowerUp* powerUp = powerUps.acquire(type);
+        float x = RandomGenerator::gameplay().range(50.0f, SCREEN_WIDTH - 50.0f);
+        if (powerUp) powerUp->setPosition(Vector2(x, -30));
     }
 
     void spawnPowerUpAt(const Vector2& pos) {
-        PowerUpType type = static_cast<PowerUpType>(RandomGenerator::range(0, 7));
-        auto powerUp = make_unique<PowerUp>(type);
-        powerUp->setPosition(pos);
-        powerUps.push_back(move(powerUp));
+        PowerUpType type = static_cast<PowerUpType>(RandomGenerator::gameplay().range(0, 7));
+        PowerUp* powerUp = powerUps.acquire(type);
+        if (powerUp) powerUp->setPosition(pos);
     }
 
     void removeInactiveObjects() {
         enemies.erase(remove_if(enemies.begin(), enemies.end(),
             [](const unique_ptr<Enemy>& e) { return !e->isActive(); }), enemies.end());
-        bullets.erase(remove_if(bullets.begin(), bullets.end(),
-            [](const unique_ptr<Bullet>& b) { return !b->isActive(); }), bullets.end());
-        powerUps.erase(remove_if(powerUps.begin(), powerUps.end(),
-            [](const unique_ptr<PowerUp>& p) { return !p->isActive(); }), powerUps.end());
-        explosions.erase(remove_if(explosions.begin(), explosions.end(),
-            [](const unique_ptr<Explosion>& e) { return !e->isActive(); }), explosions.end());
+        bullets.removeInactive();
+        powerUps.removeInactive();
+        explosions.removeInactive();
     }
 
     void nextPhase() {
@@ -1887,7 +6141,7 @@ public:
                 return;
             }
 
-            SoundManager::getInstance().playSound("level_up");
+            SoundManager::getInstance().playSound(SoundId::LevelUp);
         }
 
         phaseTimer = 25.0f + currentLevel * 5;
@@ -1905,27 +6159,31 @@ public:
             float x = 80 + (i % 8) * 130;
             float y = -50 - (i / 8) * 80;
 
-            int randType = RandomGenerator::range(0, 100);
+            int randType = RandomGenerator::gameplay().range(0, 100);
 
-            if (currentLevel == 1) {
-                if (currentPhase == 1) {
-                    if (randType < 60) enemy = make_unique<AlphaEnemy>(currentLevel, currentPhase);
-                    else enemy = make_unique<BetaEnemy>(currentLevel, currentPhase);
+            {
+                // Only reaches the heap once the enemy arena is full
+                AllocationReason reason("spawn");
+                if (currentLevel == 1) {
+                    if (currentPhase == 1) {
+                        if (randType < 60) enemy = make_unique<AlphaEnemy>(currentLevel, currentPhase);
+                        else enemy = make_unique<BetaEnemy>(currentLevel, currentPhase);
+                    }
+                    else {
+                        if (randType < 40) enemy = make_unique<AlphaEnemy>(currentLevel, currentPhase);
+                        else if (randType < 70) enemy = make_unique<BetaEnemy>(currentLevel, currentPhase);
+                        else enemy = make_unique<GammaEnemy>(currentLevel, currentPhase);
+                    }
                 }
                 else {
-                    if (randType < 40) enemy = make_unique<AlphaEnemy>(currentLevel, currentPhase);
-                    else if (randType < 70) enemy = make_unique<BetaEnemy>(currentLevel, currentPhase);
-                    else enemy = make_unique<GammaEnemy>(currentLevel, currentPhase);
+                    if (randType < 20) enemy = make_unique<AlphaEnemy>(currentLevel, currentPhase);
+                    else if (randType < 40) enemy = make_unique<BetaEnemy>(currentLevel, currentPhase);
+                    else if (randType < 55) enemy = make_unique<GammaEnemy>(currentLevel, currentPhase);
+                    else if (randType < 70) enemy = make_unique<MonsterEnemy>(currentLevel, currentPhase);
+                    else if (randType < 85) enemy = make_unique<PhantomEnemy>(currentLevel, currentPhase);
+                    else enemy = make_unique<DragonEnemy>(currentLevel, currentPhase);
                 }
             }
-            else {
-                if (randType < 20) enemy = make_unique<AlphaEnemy>(currentLevel, currentPhase);
-                else if (randType < 40) enemy = make_unique<BetaEnemy>(currentLevel, currentPhase);
-                else if (randType < 55) enemy = make_unique<GammaEnemy>(currentLevel, currentPhase);
-                else if (randType < 70) enemy = make_unique<MonsterEnemy>(currentLevel, currentPhase);
-                else if (randType < 85) enemy = make_unique<PhantomEnemy>(currentLevel, currentPhase);
-                else enemy = make_unique<DragonEnemy>(currentLevel, currentPhase);
-            }
 
             enemy->setPosition(Vector2(x, y));
             enemies.push_back(move(enemy));
@@ -1937,16 +6195,88 @@ public:
         shakeTimer = duration;
     }
 
+    const BulletPool& getBulletPool() const { return bullets; }
+
+    // ========== BENCHMARK SCENARIOS ==========
+
+    // A fresh game already in the given level and phase, which never runs out
+    // on its own. Levels past MAX_LEVELS are the boss level.
+    void startScenario(uint64_t seed, int level, int phase) {
+        startGame(seed);
+        currentLevel = level;
+        currentPhase = phase;
+        phaseTimer = 1e9f;
+        if (level > MAX_LEVELS) {
+            enemies.clear();
+            isBossLevel = true;
+            boss = make_unique<FinalBoss>();
+            // Skip the entry descent so the scene is the fight from the first tick
+            boss->setPosition(Vector2(SCREEN_WIDTH / 2, 150));
+        }
+        else {
+            spawnEnemies();
+        }
+    }
+
+    void addEnemy(unique_ptr<Enemy> enemy, const Vector2& pos) {
+        enemy->setPosition(pos);
+        enemies.push_back(move(enemy));
+    }
+
+    void addPowerUp(PowerUpType type, const Vector2& pos) {
+        PowerUp* powerUp = powerUps.acquire(type);
+        if (powerUp) powerUp->setPosition(pos);
+    }
+
+    void setParticleCapacity(int capacity) { particles = ParticleSystem(capacity); }
+    ParticleSystem& getParticles() { return particles; }
+    Spaceship& getPlayer() { return *player; }
+    FinalBoss* getBoss() { return boss.get(); }
+
+    void setTickTiming(bool enabled) {
+        tickTimingEnabled = enabled;
+        tickTimings = snapshotTimings = TickTimings();
+    }
+    const TickTimings& getTickTimings() const { return tickTimings; }
+
     // ========== DRAWING FUNCTIONS ==========
 
     void draw(sf::RenderWindow& window) {
+        ProfileZone zone("GameState::draw");
+#ifdef PERF_OVERLAY
+        auto drawStart = chrono::steady_clock::now();
+        frameMs = chrono::duration<double, milli>(drawStart - lastFrameAt).count();
+        lastFrameAt = drawStart;
+        frameDrawCalls = 0;
+        overlaySnapshot = nullptr;
+#endif
         window.clear(sf::Color(5, 5, 15));
 
+        // Gameplay draws the newest snapshot, so the simulation carries on
+        // meanwhile; every other screen reads live state and holds it off
+        unique_lock<mutex> lock(stateMutex);
+        const GameScreen screen = currentScreen;
+        const Vector2 shake = shakeOffset;
+
+        // Static layers are rebuilt on the way into a screen; for Pause that
+        // freezes the gameplay frame it was entered from. The retained screens
+        // pick up whatever changed while they were hidden (scores, sound).
+        // Done before the lock goes, since the refresh reads live state
+        if (screen != lastDrawnScreen) {
+            invalidateLayers();
+            refreshMenuUi();
+            refreshHighScoreUi();
+            refreshEndScreenUi();
+            lastDrawnScreen = screen;
+        }
+        if (screen == GameScreen::Gameplay) lock.unlock();
+
         sf::View view = window.getDefaultView();
-        view.move(shakeOffset.x, shakeOffset.y);
+        view.move(shake.x, shake.y);
         window.setView(view);
+        auto screenStart = chrono::steady_clock::now();
 
-        switch (currentScreen) {
+        switch (screen) {
         case GameScreen::Intro: drawIntro(window); break;
         case GameScreen::Menu: drawMenu(window); break;
         case GameScreen::Instructions: drawInstructions(window); break;
@@ -1957,19 +6287,48 @@ public:
         case GameScreen::Victory: drawVictory(window); break;
         case GameScreen::BossWarning: drawBossWarning(window); break;
         }
+        if (lock.owns_lock()) lock.unlock();
+        screenDrawMs[static_cast<int>(screen)] +=
+            chrono::duration<double, milli>(chrono::steady_clock::now() - screenStart).count();
+        screenDrawFrames[static_cast<int>(screen)]++;
 
         window.setView(window.getDefaultView());
-        window.display();
+#ifdef PERF_OVERLAY
+        if (perfOverlayVisible && overlaySnapshot) drawPerfOverlay(window, drawStart);
+#endif
+        {
+            // Includes the frame-limit sleep, kept apart from the drawing
+            ProfileZone displayZone("RenderWindow::display");
+            window.display();
+        }
+        framesDrawn++;
+    }
+
+#ifdef PERF_OVERLAY
+    void drawPerfOverlay(sf::RenderWindow& window, chrono::steady_clock::time_point drawStart) {
+        // A snapshot drawn a second time brings no new ticks with it
+        bool fresh = snapshots.getFreshReadCount() != overlayFreshReads;
+        overlayFreshReads = snapshots.getFreshReadCount();
+        perfOverlay.addFrame(frameMs, inputMs, drawMs, hudMs, fresh ? overlaySnapshot->timings : TickTimings(),
+            overlaySnapshot->counts, frameDrawCalls);
+        perfOverlay.draw(window);
+
+        // Includes the overlay itself; shown from the next frame on
+        drawMs = chrono::duration<double, milli>(chrono::steady_clock::now() - drawStart).count();
     }
+#endif
 
-    void drawIntro(sf::RenderWindow& window) {
+    void drawIntro(sf::RenderTarget& window) {
         // Draw intro image/video frame
         window.draw(introSprite);
 
         // Fade overlay
-        sf::RectangleShape overlay(sf::Vector2f(SCREEN_WIDTH, SCREEN_HEIGHT));
-        overlay.setFillColor(sf::Color(0, 0, 0, 150));
-        window.draw(overlay);
+        primitives.addRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, sf::Color(0, 0, 0, 150));
+        primitives.flush(window);
+
+        if (!assetsReady()) {
+            drawLoadingProgress(window);
+        }
 
         if (!fontLoaded) return;
 
@@ -1993,7 +6352,8 @@ public:
             window.draw(text);
         }
 
-        // Skip hint
+        // Skip hint (skipping is only possible once everything is loaded)
+        if (!assetsReady()) return;
         sf::Text skipText;
         skipText.setFont(gameFont);
         skipText.setString("Press SPACE or ENTER to skip");
@@ -2004,217 +6364,184 @@ public:
 
         // Progress bar
         float progress = static_cast<float>(currentIntroText) / introTexts.size();
-        sf::RectangleShape progressBg(sf::Vector2f(400, 4));
-        progressBg.setPosition(SCREEN_WIDTH / 2 - 200, SCREEN_HEIGHT - 80);
-        progressBg.setFillColor(sf::Color(50, 50, 50));
-        window.draw(progressBg);
-
-        sf::RectangleShape progressBar(sf::Vector2f(400 * progress, 4));
-        progressBar.setPosition(SCREEN_WIDTH / 2 - 200, SCREEN_HEIGHT - 80);
-        progressBar.setFillColor(sf::Color(100, 150, 255));
-        window.draw(progressBar);
+        primitives.addRect(SCREEN_WIDTH / 2 - 200, SCREEN_HEIGHT - 80, 400, 4, sf::Color(50, 50, 50));
+        primitives.addRect(SCREEN_WIDTH / 2 - 200, SCREEN_HEIGHT - 80, 400 * progress, 4, sf::Color(100, 150, 255));
+        primitives.flush(window);
     }
 
-    void drawMenu(sf::RenderWindow& window) {
-        window.draw(menuBackground);
-        starfield->draw(window);
+    void drawLoadingProgress(sf::RenderTarget& window) {
+        float progress = assetLoader.getProgress();
+        primitives.addRect(SCREEN_WIDTH / 2 - 200, SCREEN_HEIGHT - 50, 400, 4, sf::Color(50, 50, 50));
+        primitives.addRect(SCREEN_WIDTH / 2 - 200, SCREEN_HEIGHT - 50, 400 * progress, 4, sf::Color(255, 200, 100));
+        primitives.flush(window);
 
         if (!fontLoaded) return;
+        sf::Text loadingText;
+        loadingText.setFont(gameFont);
+        loadingText.setString("Loading assets... " + to_string(assetLoader.getLoadedCount()) +
+            "/" + to_string(assetLoader.getTotalCount()));
+        loadingText.setCharacterSize(18);
+        loadingText.setFillColor(sf::Color(150, 150, 150));
+        loadingText.setPosition(SCREEN_WIDTH / 2 - 200, SCREEN_HEIGHT - 40);
+        window.draw(loadingText);
+    }
 
-        // Logo
-        window.draw(logoSprite);
+    void drawMenu(sf::RenderTarget& window) {
+        if (menuUi.isDirty()) menuLayers.invalidate("options");
+        menuLayers.draw(window, *this);
+    }
 
-        // Menu options
-        vector<pair<string, string>> menuItems = {
-            {"ENTER", "Start Game"},
-            {"I", "Instructions"},
-            {"H", "High Scores"},
-            {"S", "Toggle Sound: " + string(soundEnabled ? "ON" : "OFF")},
-            {"ESC", "Exit Game"}
-        };
+    void drawMenuBackground(sf::RenderTarget& target) {
+        drawCounted(target, menuBackground);
+    }
 
-        float startY = 300;
-        for (size_t i = 0; i < menuItems.size(); i++) {
-            // Key box
-            sf::RectangleShape keyBox(sf::Vector2f(60, 40));
-            keyBox.setPosition(SCREEN_WIDTH / 2 - 180, startY + i * 60);
-            keyBox.setFillColor(sf::Color(30, 30, 60));
-            keyBox.setOutlineColor(sf::Color(100, 150, 255));
-            keyBox.setOutlineThickness(2);
-            window.draw(keyBox);
-
-            sf::Text keyText;
-            keyText.setFont(gameFont);
-            keyText.setString(menuItems[i].first);
-            keyText.setCharacterSize(16);
-            keyText.setFillColor(sf::Color(100, 200, 255));
-            keyText.setPosition(SCREEN_WIDTH / 2 - 170, startY + i * 60 + 10);
-            window.draw(keyText);
-
-            sf::Text optionText;
-            optionText.setFont(gameFont);
-            optionText.setString(menuItems[i].second);
-            optionText.setCharacterSize(24);
-            optionText.setFillColor(sf::Color::White);
-            optionText.setPosition(SCREEN_WIDTH / 2 - 100, startY + i * 60 + 8);
-            window.draw(optionText);
-        }
-
-        // Difficulty selector
-        sf::Text diffText;
-        diffText.setFont(gameFont);
-        string diffStr = difficulty < 1.0f ? "EASY" : (difficulty < 1.3f ? "NORMAL" : "HARD");
-        diffText.setString("Difficulty: " + diffStr + " (D to change)");
-        diffText.setCharacterSize(18);
-        diffText.setFillColor(sf::Color(200, 200, 100));
-        diffText.setPosition(SCREEN_WIDTH / 2 - 140, SCREEN_HEIGHT - 80);
-        window.draw(diffText);
-    }
-
-    void drawInstructions(sf::RenderWindow& window) {
-        window.draw(menuBackground);
-        starfield->draw(window);
+    void drawStars(sf::RenderTarget& target) {
+        starfield->draw(target);
+    }
 
+    // Cached in menuLayers; redrawn when menuUi changes
+    void drawMenuOptions(sf::RenderTarget& window) {
         if (!fontLoaded) return;
+        menuUi.draw(window);
+    }
 
-        sf::Text title;
-        title.setFont(gameFont);
-        title.setString("INSTRUCTIONS");
-        title.setCharacterSize(48);
-        title.setFillColor(sf::Color(100, 200, 255));
-        title.setPosition(SCREEN_WIDTH / 2 - 180, 40);
-        window.draw(title);
+    void drawInstructions(sf::RenderTarget& window) {
+        window.draw(menuBackground);
+        starfield->draw(window);
 
-        vector<string> instructions = {
-            "CONTROLS:",
-            "  Arrow Keys / WASD - Move spaceship",
-            "  SPACE - Fire weapons",
-            "  P - Pause game",
-            "  M - Toggle sound",
-            "  ESC - Return to menu",
-            "",
-            "POWER-UPS:",
-            "  Yellow - Increase weapon power",
-            "  Orange - Faster fire rate",
-            "  Blue - Shield protection",
-            "  Green - Extra life + heal",
-            "  Purple - Multi-shot upgrade",
-            "  Red - Temporary invincibility",
-            "  Dark Purple - Screen nuke",
-            "  Cyan - Slow time",
-            "",
-            "OBJECTIVE:",
-            "  Survive 2 levels with 2 phases each",
-            "  Then defeat EMPEROR DESTRUCTON!",
-            "",
-            "Press ESC to return"
-        };
+        if (!fontLoaded) return;
+        instructionsUi.draw(window);
+    }
 
-        float y = 110;
-        for (const auto& line : instructions) {
-            sf::Text text;
-            text.setFont(gameFont);
-            text.setString(line);
-            text.setCharacterSize(18);
-            text.setFillColor(line.find(':') != string::npos ? sf::Color(255, 200, 100) : sf::Color::White);
-            text.setPosition(100, y);
-            window.draw(text);
-            y += 25;
+    // Sprite layers are batched: one draw call per texture page, unless inOrder
+    // asks for the layer's own order (a sprite drawn over another on a different page)
+    void drawSprites(sf::RenderTarget& window, const vector<SpriteInstance>& layer, float alpha, bool inOrder = false) {
+        TextureManager& tm = TextureManager::getInstance();
+        for (const SpriteInstance& instance : layer) {
+            const TextureRegion* region = tm.findRegion(instance.texture);
+            if (!region || !region->texture) continue;
+
+            sf::Sprite sprite(*region->texture, instance.rect);
+            sprite.setOrigin(instance.origin);
+            sprite.setPosition(instance.position);
+            sprite.setRotation(instance.rotation);
+            sprite.setScale(instance.scale);
+            sprite.setColor(instance.color);
+
+            // Back from the captured tick towards the one before it
+            sf::Transform interpolation;
+            interpolation.translate(instance.lag * (1.0f - alpha));
+            spriteBatch.add(sprite, interpolation);
+            if (inOrder) spriteBatch.flush(window);
         }
+        spriteBatch.flush(window);
     }
 
-    void drawGameplay(sf::RenderWindow& window) {
-        // Draw appropriate background
-        if (isBossLevel) {
-            window.draw(bossBackground);
+    // Batched with whatever else goes into primitives before the next flush
+    void addHealthBars(const vector<HealthBarInstance>& bars, float alpha) {
+        const float barHeight = 6.0f;
+        for (const HealthBarInstance& healthBar : bars) {
+            sf::Vector2f corner = sf::Vector2f(healthBar.x, healthBar.y) + healthBar.lag * (1.0f - alpha);
+
+            // Background
+            primitives.addOutlinedRect(corner.x, corner.y, healthBar.width, barHeight,
+                sf::Color(60, 60, 60), sf::Color::Black, 1);
+
+            // Health bar with color gradient
+            sf::Color healthColor;
+            if (healthBar.fraction > 0.6f) healthColor = sf::Color(50, 205, 50);
+            else if (healthBar.fraction > 0.3f) healthColor = sf::Color(255, 200, 0);
+            else healthColor = sf::Color(220, 50, 50);
+            primitives.addRect(corner.x, corner.y, healthBar.width * healthBar.fraction, barHeight, healthColor);
         }
-        else {
-            window.draw(gameBackground);
+    }
+
+    // Drawn last, over the whole scene
+    void drawHud(sf::RenderTarget& window, const HudValues& hud) {
+        ProfileZone zone("GameState::drawHud");
+#ifdef PERF_OVERLAY
+        auto hudStart = chrono::steady_clock::now();
+#endif
+        if (hud.bossPresent) retainedHud.drawBoss(window, hud);
+        if (fontLoaded) {
+            retainedHud.drawPlayer(window, hud);
+            retainedHud.drawLevel(window, hud);
         }
+#ifdef PERF_OVERLAY
+        hudMs = chrono::duration<double, milli>(chrono::steady_clock::now() - hudStart).count();
+#endif
+    }
 
-        starfield->draw(window);
-        particles.draw(window);
+    // Draws the newest published snapshot; never touches the live game objects
+    void drawGameplay(sf::RenderTarget& window) {
+        ProfileZone zone("GameState::drawGameplay");
+        const RenderSnapshot& frame = snapshots.acquire();
+        const HudValues& hud = frame.hud;
+        const float alpha = frame.renderAlpha();
+#ifdef PERF_OVERLAY
+        overlaySnapshot = &frame;
+#endif
 
-        // Draw power-ups
-        for (auto& powerUp : powerUps) {
-            powerUp->draw(window);
+        // Draw appropriate background
+        if (hud.bossLevel) {
+            drawCounted(window, bossBackground);
         }
-
-        // Draw bullets
-        for (auto& bullet : bullets) {
-            bullet->draw(window);
+        else {
+            drawCounted(window, gameBackground);
         }
 
-        // Draw enemies
-        for (auto& enemy : enemies) {
-            enemy->draw(window);
+        frame.stars.draw(window);
+        frame.particles.draw(window);
+
+        drawSprites(window, frame.powerUps, alpha);
+        drawSprites(window, frame.bullets, alpha);
+
+        // Draw enemies, then their health bars on top; the boss shield goes
+        // into the same draw call
+        drawSprites(window, frame.enemies, alpha);
+        addHealthBars(frame.healthBars, alpha);
+        if (hud.bossPresent && frame.bossShield) {
+            float radius = frame.bossShieldRadius;
+            sf::Vector2f center = frame.bossShieldCenter + frame.bossShieldLag * (1.0f - alpha);
+            primitives.addCircle(center, radius, sf::Color(100, 150, 255, 60));
+            primitives.addRing(center, radius, radius + 3, sf::Color(150, 200, 255, 150));
         }
+        primitives.flush(window);
 
         // Draw boss
-        if (isBossLevel && boss) {
-            boss->draw(window);
-            boss->drawBossHealthBar(window, gameFont);
+        if (hud.bossPresent) {
+            drawSprites(window, frame.boss, alpha, true);
         }
 
-        // Draw explosions
-        for (auto& explosion : explosions) {
-            explosion->draw(window);
-        }
+        drawSprites(window, frame.explosions, alpha);
 
         // Draw player
-        player->draw(window);
+        frame.thrust.draw(window);
+        drawSprites(window, frame.player, alpha, true);
 
         // Draw HUD
-        if (fontLoaded) {
-            player->drawHUD(window, gameFont);
-
-            // Level/Phase indicator
-            if (!isBossLevel) {
-                sf::Text levelText;
-                levelText.setFont(gameFont);
-                levelText.setString("Level " + to_string(currentLevel) + " - Phase " + to_string(currentPhase) + "/" + to_string(PHASES_PER_LEVEL));
-                levelText.setCharacterSize(20);
-                levelText.setFillColor(sf::Color(150, 200, 255));
-                levelText.setPosition(SCREEN_WIDTH - 250, 20);
-                window.draw(levelText);
-
-                sf::Text enemyText;
-                enemyText.setFont(gameFont);
-                enemyText.setString("Enemies: " + to_string(enemies.size()));
-                enemyText.setCharacterSize(16);
-                enemyText.setFillColor(sf::Color(200, 150, 150));
-                enemyText.setPosition(SCREEN_WIDTH - 250, 50);
-                window.draw(enemyText);
-            }
-            else {
-                sf::Text bossText;
-                bossText.setFont(gameFont);
-                bossText.setString("=== BOSS BATTLE ===");
-                bossText.setCharacterSize(20);
-                bossText.setFillColor(sf::Color(255, 100, 100));
-                bossText.setPosition(SCREEN_WIDTH - 220, 60);
-                window.draw(bossText);
-            }
+        drawHud(window, hud);
+    }
 
-            // Slow time indicator
-            if (slowTimeTimer > 0) {
-                sf::Text slowText;
-                slowText.setFont(gameFont);
-                slowText.setString("SLOW TIME: " + to_string(static_cast<int>(slowTimeTimer)) + "s");
-                slowText.setCharacterSize(24);
-                slowText.setFillColor(sf::Color(100, 255, 255));
-                slowText.setPosition(SCREEN_WIDTH / 2 - 80, 100);
-                window.draw(slowText);
-            }
-        }
+    void drawPause(sf::RenderTarget& window) {
+        pauseLayers.draw(window, *this);
+#ifdef PERF_OVERLAY
+        // The cached layer skips drawGameplay; the frozen snapshot stays
+        // readable until the next acquire, which only gameplay makes
+        overlaySnapshot = pausedSnapshot;
+#endif
     }
 
-    void drawPause(sf::RenderWindow& window) {
+    // Rendered once per pause: the world is frozen, so the last gameplay
+    // frame stands in for it
+    void drawPausedFrame(sf::RenderTarget& window) {
         drawGameplay(window);
+#ifdef PERF_OVERLAY
+        pausedSnapshot = overlaySnapshot;
+#endif
 
-        sf::RectangleShape overlay(sf::Vector2f(SCREEN_WIDTH, SCREEN_HEIGHT));
-        overlay.setFillColor(sf::Color(0, 0, 0, 180));
-        window.draw(overlay);
+        primitives.addRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, sf::Color(0, 0, 0, 180));
+        primitives.flush(window);
 
         if (!fontLoaded) return;
 
@@ -2235,165 +6562,53 @@ public:
         window.draw(resumeText);
     }
 
-    void drawHighScores(sf::RenderWindow& window) {
-        window.draw(menuBackground);
-        starfield->draw(window);
+    void drawHighScores(sf::RenderTarget& window) {
+        if (highScoreUi.isDirty()) highScoreLayers.invalidate("table");
+        highScoreLayers.draw(window, *this);
+    }
 
+    void drawHighScoreTable(sf::RenderTarget& window) {
         if (!fontLoaded) return;
+        highScoreUi.draw(window);
+    }
 
-        sf::Text title;
-        title.setFont(gameFont);
-        title.setString("HIGH SCORES");
-        title.setCharacterSize(48);
-        title.setFillColor(sf::Color(255, 200, 100));
-        title.setPosition(SCREEN_WIDTH / 2 - 180, 50);
-        window.draw(title);
-
-        for (size_t i = 0; i < highScores.size() && i < 10; i++) {
-            sf::Text entry;
-            entry.setFont(gameFont);
-            entry.setString(to_string(i + 1) + ". " + highScores[i].first + " - " + to_string(highScores[i].second));
-            entry.setCharacterSize(24);
-            entry.setFillColor(i < 3 ? sf::Color(255, 200, 0) : sf::Color::White);
-            entry.setPosition(SCREEN_WIDTH / 2 - 200, 140 + i * 45);
-            window.draw(entry);
-        }
-
-        sf::Text backText;
-        backText.setFont(gameFont);
-        backText.setString("Press ESC to return");
-        backText.setCharacterSize(20);
-        backText.setFillColor(sf::Color(150, 150, 200));
-        backText.setPosition(SCREEN_WIDTH / 2 - 120, SCREEN_HEIGHT - 60);
-        window.draw(backText);
-    }
-
-    void drawGameOver(sf::RenderWindow& window) {
+    void drawGameOver(sf::RenderTarget& window) {
         starfield->draw(window);
 
-        sf::RectangleShape overlay(sf::Vector2f(SCREEN_WIDTH, SCREEN_HEIGHT));
-        overlay.setFillColor(sf::Color(50, 0, 0, 200));
-        window.draw(overlay);
+        primitives.addRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, sf::Color(50, 0, 0, 200));
+        primitives.flush(window);
 
         if (!fontLoaded) return;
+        gameOverUi.draw(window);
+    }
 
-        sf::Text gameOverText;
-        gameOverText.setFont(gameFont);
-        gameOverText.setString("GAME OVER");
-        gameOverText.setCharacterSize(72);
-        gameOverText.setFillColor(sf::Color(255, 50, 50));
-        gameOverText.setPosition(SCREEN_WIDTH / 2 - 250, 120);
-        window.draw(gameOverText);
-
-        sf::Text scoreText;
-        scoreText.setFont(gameFont);
-        scoreText.setString("Final Score: " + to_string(player->getScore()));
-        scoreText.setCharacterSize(36);
-        scoreText.setFillColor(sf::Color(255, 200, 100));
-        scoreText.setPosition(SCREEN_WIDTH / 2 - 180, 240);
-        window.draw(scoreText);
-
-        sf::Text namePrompt;
-        namePrompt.setFont(gameFont);
-        namePrompt.setString("Enter your name:");
-        namePrompt.setCharacterSize(24);
-        namePrompt.setFillColor(sf::Color::White);
-        namePrompt.setPosition(SCREEN_WIDTH / 2 - 120, 340);
-        window.draw(namePrompt);
-
-        sf::Text nameText;
-        nameText.setFont(gameFont);
-        nameText.setString(playerName + "_");
-        nameText.setCharacterSize(28);
-        nameText.setFillColor(sf::Color(100, 255, 100));
-        nameText.setPosition(SCREEN_WIDTH / 2 - 100, 390);
-        window.draw(nameText);
-
-        sf::Text submitText;
-        submitText.setFont(gameFont);
-        submitText.setString("Press ENTER to submit");
-        submitText.setCharacterSize(18);
-        submitText.setFillColor(sf::Color(150, 150, 200));
-        submitText.setPosition(SCREEN_WIDTH / 2 - 120, 460);
-        window.draw(submitText);
-    }
-
-    void drawVictory(sf::RenderWindow& window) {
+    void drawVictory(sf::RenderTarget& window) {
         starfield->draw(window);
         particles.draw(window);
 
         // Celebration particles
-        if (RandomGenerator::range(0, 10) < 3) {
-            particles.emit(Vector2(RandomGenerator::range(100.0f, SCREEN_WIDTH - 100.0f), SCREEN_HEIGHT + 20),
-                Vector2(RandomGenerator::range(-50.0f, 50.0f), -300),
-                sf::Color(RandomGenerator::range(100, 255), RandomGenerator::range(100, 255), RandomGenerator::range(100, 255)),
+        if (RandomGenerator::particles().range(0, 10) < 3) {
+            particles.emit(Vector2(RandomGenerator::particles().range(100.0f, SCREEN_WIDTH - 100.0f), SCREEN_HEIGHT + 20),
+                Vector2(RandomGenerator::particles().range(-50.0f, 50.0f), -300),
+                sf::Color(RandomGenerator::particles().range(100, 255), RandomGenerator::particles().range(100, 255), RandomGenerator::particles().range(100, 255)),
                 5, 2.0f, 5.0f);
         }
 
-        sf::RectangleShape overlay(sf::Vector2f(SCREEN_WIDTH, SCREEN_HEIGHT));
-        overlay.setFillColor(sf::Color(0, 30, 0, 150));
-        window.draw(overlay);
+        primitives.addRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, sf::Color(0, 30, 0, 150));
+        primitives.flush(window);
 
         if (!fontLoaded) return;
+        victoryUi.draw(window);
+    }
 
-        sf::Text victoryText;
-        victoryText.setFont(gameFont);
-        victoryText.setString("VICTORY!");
-        victoryText.setCharacterSize(80);
-        victoryText.setFillColor(sf::Color(100, 255, 100));
-        victoryText.setPosition(SCREEN_WIDTH / 2 - 200, 100);
-        window.draw(victoryText);
-
-        sf::Text defeatText;
-        defeatText.setFont(gameFont);
-        defeatText.setString("Emperor Destructon has been defeated!");
-        defeatText.setCharacterSize(28);
-        defeatText.setFillColor(sf::Color(200, 255, 200));
-        defeatText.setPosition(SCREEN_WIDTH / 2 - 260, 220);
-        window.draw(defeatText);
-
-        sf::Text scoreText;
-        scoreText.setFont(gameFont);
-        scoreText.setString("Final Score: " + to_string(player->getScore()));
-        scoreText.setCharacterSize(36);
-        scoreText.setFillColor(sf::Color(255, 220, 100));
-        scoreText.setPosition(SCREEN_WIDTH / 2 - 180, 300);
-        window.draw(scoreText);
-
-        sf::Text namePrompt;
-        namePrompt.setFont(gameFont);
-        namePrompt.setString("Enter your name for the Hall of Fame:");
-        namePrompt.setCharacterSize(22);
-        namePrompt.setFillColor(sf::Color::White);
-        namePrompt.setPosition(SCREEN_WIDTH / 2 - 200, 400);
-        window.draw(namePrompt);
-
-        sf::Text nameText;
-        nameText.setFont(gameFont);
-        nameText.setString(playerName + "_");
-        nameText.setCharacterSize(28);
-        nameText.setFillColor(sf::Color(100, 255, 100));
-        nameText.setPosition(SCREEN_WIDTH / 2 - 100, 450);
-        window.draw(nameText);
-
-        sf::Text submitText;
-        submitText.setFont(gameFont);
-        submitText.setString("Press ENTER to submit");
-        submitText.setCharacterSize(18);
-        submitText.setFillColor(sf::Color(150, 200, 150));
-        submitText.setPosition(SCREEN_WIDTH / 2 - 120, 520);
-        window.draw(submitText);
-    }
-
-    void drawBossWarning(sf::RenderWindow& window) {
+    void drawBossWarning(sf::RenderTarget& window) {
         window.draw(bossBackground);
         starfield->draw(window);
 
         // Flashing red overlay
         float flash = sin(phaseTimer * 8) * 0.5f + 0.5f;
-        sf::RectangleShape overlay(sf::Vector2f(SCREEN_WIDTH, SCREEN_HEIGHT));
-        overlay.setFillColor(sf::Color(100, 0, 0, static_cast<sf::Uint8>(flash * 150)));
-        window.draw(overlay);
+        primitives.addRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, sf::Color(100, 0, 0, static_cast<sf::Uint8>(flash * 150)));
+        primitives.flush(window);
 
         if (!fontLoaded) return;
 
@@ -2424,14 +6639,56 @@ public:
 
     // ========== INPUT HANDLING ==========
 
+    // Main thread, once per rendered frame, with the state lock held
+    void pollInput(sf::RenderWindow& window) {
+#ifdef PERF_OVERLAY
+        auto start = chrono::steady_clock::now();
+#endif
+        sf::Event event;
+        while (window.pollEvent(event)) {
+            handleEvent(event, window);
+        }
+        handleContinuousInput();
+#ifdef PERF_OVERLAY
+        inputMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+#endif
+    }
+
     void handleEvent(sf::Event& event, sf::RenderWindow& window) {
         if (event.type == sf::Event::Closed) {
             window.close();
         }
 
+#ifdef PERF_OVERLAY
+        if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3) {
+            perfOverlayVisible = !perfOverlayVisible;
+            tickTimingEnabled = perfOverlayVisible;
+            return;
+        }
+#endif
+
+        if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F4) {
+            // First press starts a capture, the next one takes it; the file is
+            // written once the state lock is released (see writePendingTrace)
+            if (Profiler::isEnabled()) {
+                Profiler::stop();
+                pendingTrace = Profiler::capture();
+                tracePending = true;
+            }
+            else {
+                Profiler::start();
+                cout << "[OK] Profiling; press F4 again to write " << profilePath << endl;
+            }
+            return;
+        }
+
+        // A replay has the controls until it ends
+        if (replay) return;
+
         if (event.type == sf::Event::KeyPressed) {
             switch (currentScreen) {
             case GameScreen::Intro:
+                if (!assetsReady()) break;
                 if (event.key.code == sf::Keyboard::Space || event.key.code == sf::Keyboard::Return) {
                     currentScreen = GameScreen::Menu;
                     SoundManager::getInstance().playMusic("assets/menu_music.wav");
@@ -2451,11 +6708,13 @@ public:
                 else if (event.key.code == sf::Keyboard::S) {
                     soundEnabled = !soundEnabled;
                     SoundManager::getInstance().toggleSound();
+                    refreshMenuUi();
                 }
                 else if (event.key.code == sf::Keyboard::D) {
                     if (difficulty < 1.0f) difficulty = 1.0f;
                     else if (difficulty < 1.3f) difficulty = 1.5f;
                     else difficulty = 0.7f;
+                    refreshMenuUi();
                 }
                 else if (event.key.code == sf::Keyboard::Escape) {
                     window.close();
@@ -2512,34 +6771,24 @@ public:
                 else if (event.text.unicode >= 32 && event.text.unicode < 128 && playerName.length() < 12) {
                     playerName += static_cast<char>(event.text.unicode);
                 }
+                refreshNameEntry();
             }
         }
     }
 
-    void handleContinuousInput() {
-        if (currentScreen != GameScreen::Gameplay) return;
-
-        Vector2 velocity(0, 0);
-        float speed = 300.0f;
-
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Up) || sf::Keyboard::isKeyPressed(sf::Keyboard::W)) {
-            velocity.y = -speed;
-        }
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down) || sf::Keyboard::isKeyPressed(sf::Keyboard::S)) {
-            velocity.y = speed;
-        }
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left) || sf::Keyboard::isKeyPressed(sf::Keyboard::A)) {
-            velocity.x = -speed;
-        }
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right) || sf::Keyboard::isKeyPressed(sf::Keyboard::D)) {
-            velocity.x = speed;
-        }
-
-        player->setVelocity(velocity);
+    // Samples the held keys once per rendered frame; every tick until the
+    // next sample applies them (see applyInput)
+    void handleContinuousInput() {
+        if (replay) return;
+        input = PlayerInput();
+        if (currentScreen != GameScreen::Gameplay) return;
 
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Space)) {
-            firePlayerBullets();
-        }
+        using sf::Keyboard;
+        input.up = Keyboard::isKeyPressed(Keyboard::Up) || Keyboard::isKeyPressed(Keyboard::W);
+        input.down = Keyboard::isKeyPressed(Keyboard::Down) || Keyboard::isKeyPressed(Keyboard::S);
+        input.left = Keyboard::isKeyPressed(Keyboard::Left) || Keyboard::isKeyPressed(Keyboard::A);
+        input.right = Keyboard::isKeyPressed(Keyboard::Right) || Keyboard::isKeyPressed(Keyboard::D);
+        input.fire = Keyboard::isKeyPressed(Keyboard::Space);
 
         // Mute toggle
         if (sf::Keyboard::isKeyPressed(sf::Keyboard::M)) {
@@ -2554,7 +6803,35 @@ public:
         }
     }
 
+    void applyInput() {
+        Vector2 velocity(0, 0);
+        float speed = 300.0f;
+
+        if (input.up) velocity.y = -speed;
+        if (input.down) velocity.y = speed;
+        if (input.left) velocity.x = -speed;
+        if (input.right) velocity.x = speed;
+
+        player->setVelocity(velocity);
+
+        if (input.fire) {
+            firePlayerBullets();
+        }
+    }
+
+    // Each game runs from its own seed, so a recording can start it again
     void startGame() {
+        RandomStream& rng = RandomGenerator::gameplay();
+        uint64_t gameSeed = uint64_t(rng.next()) << 32;
+        gameSeed |= rng.next();
+        startGame(gameSeed);
+    }
+
+    void startGame(uint64_t gameSeed) {
+        AllocationReason reason("new-game");
+        if (recordingGame) endRecordedGame();
+        RandomGenerator::seed(gameSeed);
+
         currentScreen = GameScreen::Gameplay;
         currentLevel = 1;
         currentPhase = 1;
@@ -2573,6 +6850,14 @@ public:
         player->reset();
         spawnEnemies();
 
+        if (recorder) {
+            recorder->beginGame(gameSeed, difficulty);
+            recordingGame = true;
+        }
+
+        // The next frame is drawn from a snapshot; make sure it is of this game
+        if (!headless) publishSnapshot();
+
         SoundManager::getInstance().playMusic("assets/game_music.wav");
     }
 
@@ -2618,16 +6903,1192 @@ public:
     }
 };
 
+// ============================================================================
+// BENCHMARKS - Run with: SpaceShooter --bench [name]
+// ============================================================================
+
+// Average wall time of one call to fn, in milliseconds
+template <typename Fn>
+double timeMilliseconds(Fn&& fn, int iterations) {
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) fn();
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+void benchmarkCollisions() {
+    cout << "\n=== Collision Broadphase Benchmark (25 enemies) ===" << endl;
+    mt19937 rng(1234);
+    uniform_real_distribution<float> xDist(0.0f, SCREEN_WIDTH);
+    uniform_real_distribution<float> yDist(0.0f, SCREEN_HEIGHT);
+    uniform_real_distribution<float> radiusDist(20.0f, 40.0f);
+
+    vector<unique_ptr<Enemy>> enemies;
+    for (int i = 0; i < 25; i++) {
+        auto enemy = make_unique<AlphaEnemy>(2, 2);
+        enemy->setPosition(Vector2(xDist(rng), yDist(rng)));
+        enemy->setBoundingRadius(radiusDist(rng));
+        enemies.push_back(move(enemy));
+    }
+
+    SpatialGrid grid;
+    vector<int> candidates;
+
+    for (int bulletCount : { 1000, 10000, 50000 }) {
+        BulletPool bullets(bulletCount);
+        for (int i = 0; i < bulletCount; i++) {
+            Bullet* bullet = bullets.acquire(true, 10);
+            bullet->setPosition(Vector2(xDist(rng), yDist(rng)));
+        }
+
+        int bruteHits = 0;
+        int gridHits = 0;
+        int iterations = max(5, 200000 / bulletCount);
+
+        double bruteMs = timeMilliseconds([&]() {
+            bruteHits = 0;
+            for (auto& bullet : bullets) {
+                for (auto& enemy : enemies) {
+                    // The pre-broadphase test: a sqrt per bullet/enemy pair
+                    float dist = bullet.getPosition().distanceTo(enemy->getPosition());
+                    if (dist < bullet.getBoundingRadius() + enemy->getBoundingRadius()) bruteHits++;
+                }
+            }
+        }, iterations);
+
+        double gridMs = timeMilliseconds([&]() {
+            gridHits = 0;
+            grid.clear();
+            for (size_t i = 0; i < enemies.size(); i++)
+                grid.insert(static_cast<int>(i), enemies[i]->getPosition(), enemies[i]->getBoundingRadius());
+            grid.build();
+            for (auto& bullet : bullets) {
+                grid.query(bullet.getPosition(), bullet.getBoundingRadius(), candidates);
+                for (int e : candidates) {
+                    if (bullet.checkCollision(enemies[e].get())) gridHits++;
+                }
+            }
+        }, iterations);
+
+        cout << "  bullets=" << bulletCount
+            << "  all-pairs=" << bruteMs << " ms"
+            << "  grid=" << gridMs << " ms"
+            << "  speedup=" << bruteMs / gridMs << "x"
+            << "  hits=" << gridHits << (gridHits == bruteHits ? " (match)" : " (MISMATCH)") << endl;
+    }
+}
+
+void benchmarkParticles() {
+    cout << "\n=== Particle Update Benchmark (SoA vs old deque of structs) ===" << endl;
+
+    // The previous array-of-structs particle, kept here only as the baseline
+    struct DequeParticle {
+        Vector2 position, velocity;
+        sf::Color color;
+        float lifetime, maxLifetime, size, rotation, rotationSpeed;
+
+        void update(float dt) {
+            position = position + velocity * dt;
+            velocity = velocity * 0.98f;
+            lifetime -= dt;
+            rotation += rotationSpeed * dt;
+            float alpha = (lifetime / maxLifetime) * 255.0f;
+            color.a = static_cast<sf::Uint8>(max(0.0f, alpha));
+        }
+    };
+
+    const float dt = 1.0f / 60.0f;
+    const int frames = 120;
+
+    for (int particleCount : { 500, 10000, 100000 }) {
+        ParticleSystem soa(particleCount);
+        deque<DequeParticle> legacy;
+        for (int i = 0; i < particleCount; i++) {
+            Vector2 vel(RandomGenerator::particles().range(-80.0f, 80.0f), RandomGenerator::particles().range(-80.0f, 80.0f));
+            legacy.push_back({ Vector2(600, 400), vel, sf::Color::White, 100.0f, 100.0f, 3.0f, 0.0f,
+                RandomGenerator::particles().range(-180.0f, 180.0f) });
+        }
+        soa.emit(Vector2(600, 400), Vector2(0, 0), sf::Color::White, particleCount, 100.0f);
+
+        double legacyMs = timeMilliseconds([&]() {
+            for (auto& p : legacy) p.update(dt);
+            while (!legacy.empty() && legacy.front().lifetime <= 0) legacy.pop_front();
+        }, frames);
+        double soaMs = timeMilliseconds([&]() { soa.update(dt); }, frames);
+
+        cout << "  particles=" << particleCount
+            << "  deque=" << legacyMs * 1e6 / particleCount << " ns/particle"
+            << "  soa=" << soaMs * 1e6 / particleCount << " ns/particle"
+            << "  speedup=" << legacyMs / soaMs << "x" << endl;
+    }
+
+    // A single long-lived particle at the front used to pin everything behind it
+    ParticleSystem soa(1000);
+    deque<DequeParticle> legacy;
+    soa.emit(Vector2(0, 0), Vector2(0, 0), sf::Color::White, 1, 100.0f);
+    legacy.push_back({ Vector2(0, 0), Vector2(0, 0), sf::Color::White, 100.0f, 100.0f, 3.0f, 0.0f, 0.0f });
+    soa.emit(Vector2(0, 0), Vector2(0, 0), sf::Color::White, 999, 0.5f);
+    for (int i = 0; i < 999; i++) {
+        legacy.push_back({ Vector2(0, 0), Vector2(0, 0), sf::Color::White, 0.5f, 0.5f, 3.0f, 0.0f, 0.0f });
+    }
+    for (int f = 0; f < frames; f++) {
+        soa.update(dt);
+        for (auto& p : legacy) p.update(dt);
+        while (!legacy.empty() && legacy.front().lifetime <= 0) legacy.pop_front();
+    }
+    cout << "  after 2s with one long-lived particle: deque holds " << legacy.size()
+        << ", soa holds " << soa.getCount() << endl;
+}
+
+// The old RandomGenerator (one mt19937, a distribution built per call) against
+// a RandomStream, per call and through the bulk fill
+void benchmarkRandom() {
+    cout << "\n=== Random numbers: mt19937 + distributions vs xoshiro128** ===" << endl;
+    const int count = 1000000;
+    mt19937 legacyGenerator(12345);
+    RandomStream stream(12345);
+    vector<float> out(count);
+    volatile float floatSink = 0;
+    volatile int intSink = 0;
+
+    double legacyFloatMs = timeMilliseconds([&]() {
+        float sum = 0;
+        for (int i = 0; i < count; i++) {
+            uniform_real_distribution<float> dist(-80.0f, 80.0f);
+            sum += dist(legacyGenerator);
+        }
+        floatSink = sum;
+    }, 5);
+    double streamFloatMs = timeMilliseconds([&]() {
+        float sum = 0;
+        for (int i = 0; i < count; i++) sum += stream.range(-80.0f, 80.0f);
+        floatSink = sum;
+    }, 5);
+    double fillMs = timeMilliseconds([&]() {
+        stream.fill(out.data(), out.size(), -80.0f, 80.0f);
+        floatSink = out[count / 2];
+    }, 5);
+
+    double legacyIntMs = timeMilliseconds([&]() {
+        int sum = 0;
+        for (int i = 0; i < count; i++) {
+            uniform_int_distribution<int> dist(0, 100);
+            sum += dist(legacyGenerator);
+        }
+        intSink = sum;
+    }, 5);
+    double streamIntMs = timeMilliseconds([&]() {
+        int sum = 0;
+        for (int i = 0; i < count; i++) sum += stream.range(0, 100);
+        intSink = sum;
+    }, 5);
+
+    cout << "  float range: mt19937=" << legacyFloatMs * 1e6 / count << " ns  stream="
+        << streamFloatMs * 1e6 / count << " ns  fill=" << fillMs * 1e6 / count << " ns"
+        << "  speedup=" << legacyFloatMs / streamFloatMs << "x (fill " << legacyFloatMs / fillMs << "x)" << endl;
+    cout << "  int range:   mt19937=" << legacyIntMs * 1e6 / count << " ns  stream="
+        << streamIntMs * 1e6 / count << " ns  speedup=" << legacyIntMs / streamIntMs << "x" << endl;
+
+    // Sanity: bounds and a rough uniformity check on the inclusive int range
+    int histogram[4] = {};
+    bool inRange = true;
+    for (int i = 0; i < count; i++) {
+        int v = stream.range(0, 3);
+        if (v < 0 || v > 3) inRange = false;
+        else histogram[v]++;
+        float f = stream.range(-1.0f, 1.0f);
+        if (f < -1.0f || f >= 1.0f) inRange = false;
+    }
+    cout << "  range(0, 3) buckets: " << histogram[0] << " " << histogram[1] << " " << histogram[2] << " "
+        << histogram[3] << (inRange ? "  (all in range)" : "  OUT OF RANGE") << endl;
+}
+
+// Everything the game loads at startup, from loose files and from the bundle.
+// Single-threaded on purpose so the two formats are compared like for like;
+// run it twice to see warm-cache numbers.
+void benchmarkStartup() {
+    cout << "\n=== Startup: loose files vs asset bundle ===" << endl;
+    const int iterations = 5;
+
+    int looseLoaded = 0;
+    double looseMs = timeMilliseconds([&] {
+        looseLoaded = 0;
+        vector<sf::Texture> textures(size(TEXTURE_ASSETS));
+        for (size_t i = 0; i < textures.size(); i++) {
+            sf::Image image;
+            if (image.loadFromFile(TEXTURE_ASSETS[i].path) && textures[i].loadFromImage(image)) looseLoaded++;
+        }
+        vector<sf::SoundBuffer> buffers(size(SOUND_ASSETS));
+        for (size_t i = 0; i < buffers.size(); i++) {
+            vector<sf::Int16> samples;
+            unsigned channelCount = 0, sampleRate = 0;
+            if (decodeSoundFile(SOUND_ASSETS[i].path, samples, channelCount, sampleRate) &&
+                buffers[i].loadFromSamples(samples.data(), samples.size(), channelCount, sampleRate)) looseLoaded++;
+        }
+        vector<char> fontBytes;
+        sf::Font font;
+        if (!readFontFile(fontBytes).empty() && font.loadFromMemory(fontBytes.data(), fontBytes.size())) looseLoaded++;
+    }, iterations);
+    cout << "  loose files: " << looseMs << " ms (" << looseLoaded << " assets)" << endl;
+
+    int bundleLoaded = 0;
+    bool bundleFound = true;
+    double bundleMs = timeMilliseconds([&] {
+        bundleLoaded = 0;
+        AssetBundle bundle;
+        if (!bundle.open(ASSET_BUNDLE_PATH)) {
+            bundleFound = false;
+            return;
+        }
+        vector<sf::Texture> textures;
+        vector<sf::SoundBuffer> buffers;
+        sf::Font font;
+        textures.reserve(bundle.getEntryCount());
+        buffers.reserve(bundle.getEntryCount());
+        for (uint32_t i = 0; i < bundle.getEntryCount(); i++) {
+            const BundleEntry& entry = bundle.getEntry(i);
+            const sf::Uint8* data = bundle.getData(entry);
+            if (entry.type == BUNDLE_TEXTURE) {
+                textures.emplace_back();
+                if (textures.back().create(entry.params[0], entry.params[1])) {
+                    textures.back().update(data);
+                    bundleLoaded++;
+                }
+            }
+            else if (entry.type == BUNDLE_SOUND) {
+                buffers.emplace_back();
+                if (buffers.back().loadFromSamples(reinterpret_cast<const sf::Int16*>(data),
+                    static_cast<size_t>(entry.size / sizeof(sf::Int16)), entry.params[0], entry.params[1])) bundleLoaded++;
+            }
+            else if (entry.type == BUNDLE_FONT) {
+                if (font.loadFromMemory(data, static_cast<size_t>(entry.size))) bundleLoaded++;
+            }
+        }
+    }, iterations);
+
+    if (!bundleFound) {
+        cout << "  no bundle at " << ASSET_BUNDLE_PATH << " (create one with --pack-assets)" << endl;
+        return;
+    }
+    // The bundle holds atlas pages instead of individual sprites, so its count is lower
+    cout << "  bundle:      " << bundleMs << " ms (" << bundleLoaded << " textures/sounds/fonts)"
+        << "  speedup=" << looseMs / bundleMs << "x" << endl;
+}
+
+// Microbenchmarks: the hot primitives on their own, over parameterized input
+// sizes. Each kernel runs until at least MICRO_MIN_SECONDS have been timed and
+// reports the cost per item (one vector, pair, particle, star, number, ...).
+
+const double MICRO_MIN_SECONDS = 0.05;
+volatile float microSink = 0;   // keeps results alive past the optimizer
+
+struct MicroResult {
+    double nsPerItem = 0;
+    double itemsPerSecond = 0;
+};
+
+// prepare() is untimed and resets whatever run() consumes; run() does one op
+// over `items` inputs
+template <typename Prepare, typename Run>
+MicroResult measureKernel(size_t items, Prepare&& prepare, Run&& run) {
+    double seconds = 0;
+    long long ops = 0;
+    while (seconds < MICRO_MIN_SECONDS || ops < 3) {
+        prepare();
+        auto start = chrono::steady_clock::now();
+        run();
+        seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        ops++;
+    }
+    MicroResult result;
+    double totalItems = double(items) * ops;
+    result.nsPerItem = seconds * 1e9 / totalItems;
+    result.itemsPerSecond = totalItems / seconds;
+    return result;
+}
+
+template <typename Run>
+MicroResult measureKernel(size_t items, Run&& run) {
+    return measureKernel(items, [] {}, run);
+}
+
+void reportKernel(const char* name, size_t items, const MicroResult& result) {
+    cout << "  " << name << " [" << items << "]: " << result.nsPerItem << " ns/op, "
+        << result.itemsPerSecond / 1e6 << " M items/s" << endl;
+}
+
+void microVector2(size_t items) {
+    RandomStream rng(1);
+    vector<Vector2> a(items), b(items), out(items);
+    for (size_t i = 0; i < items; i++) {
+        a[i] = Vector2(rng.range(-500.0f, 500.0f), rng.range(-500.0f, 500.0f));
+        b[i] = Vector2(rng.range(-500.0f, 500.0f), rng.range(-500.0f, 500.0f));
+    }
+    const float dt = 1.0f / SIMULATION_TICK_RATE;
+
+    reportKernel("vector2 a + b * dt", items, measureKernel(items, [&] {
+        for (size_t i = 0; i < items; i++) out[i] = a[i] + b[i] * dt;
+        microSink = out[items / 2].x;
+    }));
+    reportKernel("vector2 normalized", items, measureKernel(items, [&] {
+        for (size_t i = 0; i < items; i++) out[i] = a[i].normalized();
+        microSink = out[items / 2].x;
+    }));
+    reportKernel("vector2 distanceTo", items, measureKernel(items, [&] {
+        float sum = 0;
+        for (size_t i = 0; i < items; i++) sum += a[i].distanceTo(b[i]);
+        microSink = sum;
+    }));
+}
+
+void microCollision(size_t items) {
+    // items objects against 25 targets, like bullets against a full wave
+    RandomStream rng(2);
+    vector<GameObject> objects(items), targets(25);
+    for (auto& object : objects) {
+        object.setPosition(Vector2(rng.range(0.0f, SCREEN_WIDTH), rng.range(0.0f, SCREEN_HEIGHT)));
+        object.setBoundingRadius(5.0f);
+    }
+    for (auto& target : targets) {
+        target.setPosition(Vector2(rng.range(0.0f, SCREEN_WIDTH), rng.range(0.0f, SCREEN_HEIGHT)));
+        target.setBoundingRadius(rng.range(20.0f, 40.0f));
+    }
+
+    size_t pairs = items * targets.size();
+    reportKernel("checkCollision (pairs)", pairs, measureKernel(pairs, [&] {
+        int hits = 0;
+        for (auto& object : objects) {
+            for (auto& target : targets) hits += object.checkCollision(&target);
+        }
+        microSink = static_cast<float>(hits);
+    }));
+}
+
+void microParticles(size_t items) {
+    const float dt = 1.0f / SIMULATION_TICK_RATE;
+    ParticleSystem system(static_cast<int>(items));
+    // Fresh particles every op: thousands of updates in a row would drag the
+    // velocities down into denormals, which no real particle lives to see
+    reportKernel("ParticleSystem::update", items, measureKernel(items,
+        [&] {
+            system.clear();
+            system.emit(Vector2(600, 400), Vector2(0, 0), sf::Color::White, static_cast<int>(items), 10.0f);
+        },
+        [&] { system.update(dt); }));
+
+    reportKernel("ParticleSystem::emit", items, measureKernel(items,
+        [&] { system.clear(); },
+        [&] { system.emit(Vector2(600, 400), Vector2(0, -50), sf::Color::Cyan, static_cast<int>(items), 1.0f); }));
+    reportKernel("ParticleSystem::emitExplosion", items, measureKernel(items,
+        [&] { system.clear(); },
+        [&] { system.emitExplosion(Vector2(600, 400), static_cast<int>(items), 4.0f); }));
+
+    Starfield starfield(static_cast<int>(items));
+    reportKernel("Starfield::update", items, measureKernel(items, [&] { starfield.update(dt); }));
+}
+
+void microRandom(size_t items) {
+    RandomStream rng(3);
+    reportKernel("RandomStream::range(float)", items, measureKernel(items, [&] {
+        float sum = 0;
+        for (size_t i = 0; i < items; i++) sum += rng.range(-80.0f, 80.0f);
+        microSink = sum;
+    }));
+    reportKernel("RandomStream::range(int)", items, measureKernel(items, [&] {
+        int sum = 0;
+        for (size_t i = 0; i < items; i++) sum += rng.range(0, 100);
+        microSink = static_cast<float>(sum);
+    }));
+}
+
+void microCompaction(size_t items) {
+    // removeInactiveObjects() on the bullet pool, with every fourth bullet dead
+    BulletPool pool(items);
+    reportKernel("BulletPool::removeInactive (1/4 dead)", items, measureKernel(items,
+        [&] {
+            pool.clear();
+            for (size_t i = 0; i < items; i++) {
+                Bullet* bullet = pool.acquire(i % 2 == 0, 10);
+                if (i % 4 == 0) bullet->setActive(false);
+            }
+        },
+        [&] { pool.removeInactive(); }));
+
+    // ...and on a vector of owned enemies, as GameState keeps them
+    vector<unique_ptr<Enemy>> enemies;
+    reportKernel("remove_if unique_ptr<Enemy> (1/4 dead)", items, measureKernel(items,
+        [&] {
+            enemies.clear();
+            for (size_t i = 0; i < items; i++) {
+                enemies.push_back(make_unique<AlphaEnemy>(1, 1));
+                if (i % 4 == 0) enemies.back()->setActive(false);
+            }
+        },
+        [&] {
+            enemies.erase(remove_if(enemies.begin(), enemies.end(),
+                [](const unique_ptr<Enemy>& e) { return !e->isActive(); }), enemies.end());
+        }));
+}
+
+void microBossAttack(size_t items) {
+    // Volleys in each boss phase, cycling through all four attack patterns;
+    // an item is one bullet fired
+    size_t volleys = min<size_t>(max<size_t>(items / 8, 4), 1024) / 4 * 4;
+    for (int phase = 1; phase <= 3; phase++) {
+        FinalBoss boss;
+        boss.setHealth(boss.getMaxHealth() * (phase == 1 ? 1.0f : phase == 2 ? 0.5f : 0.25f));
+        boss.setPosition(Vector2(SCREEN_WIDTH / 2, 200));
+        boss.update(0);   // picks the phase from health, and moves
+        boss.setPosition(Vector2(SCREEN_WIDTH / 2, 200));
+        boss.setPlayerPosition(Vector2(SCREEN_WIDTH / 2, SCREEN_HEIGHT - 100));
+
+        BulletPool pool(volleys * 20);   // the largest volley is 20 bullets
+        auto fire = [&] {
+            for (size_t i = 0; i < volleys; i++) {
+                boss.resetAttackTimer();
+                boss.fireAttackBullets(pool);
+            }
+        };
+        pool.clear();
+        fire();
+        size_t bullets = pool.size();
+
+        string name = "FinalBoss::fireAttackBullets phase " + to_string(boss.getBossPhase());
+        reportKernel(name.c_str(), bullets, measureKernel(bullets, [&] { pool.clear(); }, fire));
+    }
+}
+
+// Items per op for each kernel; one size when given on the command line
+int runMicrobenchmarks(const string& filter, size_t itemsOverride) {
+    struct Kernel {
+        const char* name;
+        void (*run)(size_t items);
+    };
+    const Kernel kernels[] = {
+        { "vector2", microVector2 },
+        { "collision", microCollision },
+        { "particles", microParticles },
+        { "random", microRandom },
+        { "compaction", microCompaction },
+        { "boss", microBossAttack },
+    };
+    vector<size_t> sizes = { 256, 4096, 65536 };
+    if (itemsOverride > 0) sizes = { itemsOverride };
+
+    cout << "\n=== Microbenchmarks (ns per item, million items per second) ===" << endl;
+    bool ran = false;
+    for (const Kernel& kernel : kernels) {
+        if (filter != "all" && filter != kernel.name) continue;
+        for (size_t items : sizes) kernel.run(items);
+        ran = true;
+    }
+    if (!ran) {
+        cerr << "Unknown microbenchmark: " << filter << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int runBenchmarks(const string& name) {
+    bool all = name == "all";
+    bool ran = false;
+    if (all || name == "collisions") { benchmarkCollisions(); ran = true; }
+    if (all || name == "particles") { benchmarkParticles(); ran = true; }
+    if (all || name == "startup") { benchmarkStartup(); ran = true; }
+    if (all || name == "random") { benchmarkRandom(); ran = true; }
+    if (all || name == "micro") { runMicrobenchmarks("all", 0); ran = true; }
+
+    if (!ran) {
+        cerr << "Unknown benchmark: " << name << endl;
+        return 1;
+    }
+    return 0;
+}
+
+// ============================================================================
+// HEADLESS MODE - Run with: SpaceShooter --headless [ticks] [--seed N] [--script file]
+//                                        [--record file] [--replay file]
+//                                        [--alloc-check [warm-up ticks]]
+//                                        [--alloc-allow reason]...
+// ============================================================================
+//
+// Soak-tests the gameplay logic with no window, no textures and no audio
+// device, running ticks back to back as fast as the CPU allows. Collision
+// radii still match the game: texture sizes come from the image headers, or
+// from the asset bundle's index when the loose files are missing.
+//
+// --alloc-check fails the run if any tick after the warm-up allocates, and
+// lists the profiling zones that did. --alloc-allow <reason> excuses the
+// allocations made under that AllocationReason ("spawn": an enemy or boss
+// past its arena's blocks, "new-game": a new game's setup); they are listed
+// apart.
+
+const long long ALLOCATION_WARMUP_TICKS = 600;
+
+// Width and height from a PNG, GIF, BMP or JPEG header, without decoding
+bool readImageSize(const string& path, unsigned& width, unsigned& height) {
+    ifstream file(path, ios::binary);
+    unsigned char header[26] = {};
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header))) return false;
+
+    auto be16 = [](const unsigned char* p) { return unsigned(p[0]) << 8 | p[1]; };
+    auto le16 = [](const unsigned char* p) { return unsigned(p[1]) << 8 | p[0]; };
+    auto be32 = [&](const unsigned char* p) { return be16(p) << 16 | be16(p + 2); };
+    auto le32 = [&](const unsigned char* p) { return le16(p + 2) << 16 | le16(p); };
+
+    if (memcmp(header, "\x89PNG\r\n\x1a\n", 8) == 0 && memcmp(header + 12, "IHDR", 4) == 0) {
+        width = be32(header + 16);
+        height = be32(header + 20);
+        return true;
+    }
+    if (memcmp(header, "GIF8", 4) == 0) {
+        width = le16(header + 6);
+        height = le16(header + 8);
+        return true;
+    }
+    if (header[0] == 'B' && header[1] == 'M') {
+        width = le32(header + 18);
+        height = static_cast<unsigned>(abs(static_cast<int32_t>(le32(header + 22))));  // negative = top-down
+        return true;
+    }
+    if (header[0] == 0xFF && header[1] == 0xD8) {
+        // Walk the segments up to the first start-of-frame
+        file.seekg(2);
+        unsigned char segment[9];
+        while (file.read(reinterpret_cast<char*>(segment), 4) && segment[0] == 0xFF) {
+            unsigned marker = segment[1];
+            bool startOfFrame = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+            if (startOfFrame) {
+                if (!file.read(reinterpret_cast<char*>(segment), 5)) return false;
+                height = be16(segment + 1);
+                width = be16(segment + 3);
+                return true;
+            }
+            file.seekg(be16(segment + 2) - 2, ios::cur);
+        }
+    }
+    return false;
+}
+
+// Records every manifest texture's size in TextureManager; returns how many were found
+int loadHeadlessTextureSizes() {
+    TextureManager& tm = TextureManager::getInstance();
+    AssetBundle bundle;
+    bool bundleTried = false;
+    int found = 0;
+
+    for (const TextureAsset& asset : TEXTURE_ASSETS) {
+        unsigned width = 0, height = 0;
+        bool ok = readImageSize(asset.path, width, height);
+        if (!ok && !bundleTried) {
+            bundle.open(ASSET_BUNDLE_PATH);
+            bundleTried = true;
+        }
+        for (uint32_t i = 0; !ok && bundle.isOpen() && i < bundle.getEntryCount(); i++) {
+            const BundleEntry& entry = bundle.getEntry(i);
+            if (strcmp(entry.name, asset.name) != 0) continue;
+            if (entry.type == BUNDLE_TEXTURE) {
+                width = entry.params[0];
+                height = entry.params[1];
+                ok = true;
+            }
+            else if (entry.type == BUNDLE_REGION) {
+                width = entry.params[3];
+                height = entry.params[4];
+                ok = true;
+            }
+        }
+
+        if (ok) {
+            tm.setTextureSize(asset.id, width, height);
+            found++;
+        }
+        else {
+            cerr << "[FAIL] No size for texture: " << asset.path << endl;
+        }
+    }
+    return found;
+}
+
+size_t peakMemoryBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);          // bytes
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;   // kilobytes
+#endif
+#endif
+}
+
+// Input for headless runs: a looping script, or random held keys
+class HeadlessInput {
+private:
+    struct Step {
+        int ticks;
+        PlayerInput keys;
+    };
+    vector<Step> script;
+    size_t nextStep = 0;
+    int ticksLeft = 0;
+    PlayerInput current;
+    RandomStream rng;
+
+public:
+    explicit HeadlessInput(uint64_t seed) : rng(seed ^ 0x1D2B3C4D5E6F7081ull) {}
+
+    // One "<ticks> <keys>" step per line, keys from U D L R F or "-" for none,
+    // e.g. "120 UF" holds up and fire for 120 ticks. Lines starting with # are comments.
+    bool loadScript(const string& path) {
+        ifstream file(path);
+        if (!file.is_open()) {
+            cerr << "[FAIL] Could not open input script: " << path << endl;
+            return false;
+        }
+        string line;
+        while (getline(file, line)) {
+            istringstream fields(line);
+            Step step;
+            string keys;
+            if (line.empty() || line[0] == '#' || !(fields >> step.ticks >> keys) || step.ticks <= 0) continue;
+            step.keys.up = keys.find('U') != string::npos;
+            step.keys.down = keys.find('D') != string::npos;
+            step.keys.left = keys.find('L') != string::npos;
+            step.keys.right = keys.find('R') != string::npos;
+            step.keys.fire = keys.find('F') != string::npos;
+            script.push_back(step);
+        }
+        if (script.empty()) {
+            cerr << "[FAIL] Input script has no steps: " << path << endl;
+            return false;
+        }
+        return true;
+    }
+
+    PlayerInput next() {
+        if (ticksLeft == 0) {
+            if (!script.empty()) {
+                current = script[nextStep].keys;
+                ticksLeft = script[nextStep].ticks;
+                nextStep = (nextStep + 1) % script.size();
+            }
+            else {
+                int vertical = rng.range(-1, 1);
+                int horizontal = rng.range(-1, 1);
+                current.up = vertical < 0;
+                current.down = vertical > 0;
+                current.left = horizontal < 0;
+                current.right = horizontal > 0;
+                current.fire = rng.nextFloat() < 0.8f;
+                ticksLeft = rng.range(10, 90);
+            }
+        }
+        ticksLeft--;
+        return current;
+    }
+};
+
+int runHeadless(int argc, char* argv[]) {
+    long long ticks = 72000;  // ten minutes of game time at 120 Hz
+    uint64_t seed = 0;
+    bool seeded = false;
+    string scriptPath, recordPath, replayPath, profilePath;
+    long long allocationWarmUp = -1;   // ticks; checking is off while negative
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--seed" && i + 1 < argc) {
+            seed = strtoull(argv[++i], nullptr, 10);
+            seeded = true;
+        }
+        else if (arg == "--script" && i + 1 < argc) scriptPath = argv[++i];
+        else if (arg == "--record" && i + 1 < argc) recordPath = argv[++i];
+        else if (arg == "--replay" && i + 1 < argc) replayPath = argv[++i];
+        else if (arg == "--profile") {
+            profilePath = i + 1 < argc && argv[i + 1][0] != '-' ? argv[++i] : PROFILE_DEFAULT_PATH;
+        }
+        else if (arg == "--alloc-check") {
+            allocationWarmUp = i + 1 < argc && isdigit(static_cast<unsigned char>(argv[i + 1][0]))
+                ? atoll(argv[++i]) : ALLOCATION_WARMUP_TICKS;
+        }
+        else if (arg == "--alloc-allow" && i + 1 < argc) {
+            const char* reason = argv[++i];
+            if (find_if(begin(ALLOCATION_REASONS), end(ALLOCATION_REASONS),
+                    [reason](const char* name) { return strcmp(name, reason) == 0; }) == end(ALLOCATION_REASONS)) {
+                cerr << "[FAIL] Unknown allocation reason: " << reason << " (spawn, new-game)" << endl;
+                return 1;
+            }
+            AllocationTracker::allow(reason);
+        }
+        else if (isdigit(static_cast<unsigned char>(arg[0]))) ticks = atoll(arg.c_str());
+    }
+    bool replaying = !replayPath.empty();
+
+    cout << "\n=== Headless Simulation ===" << endl;
+    Profiler::setThreadName("simulation");
+    if (!profilePath.empty()) Profiler::start();
+    SoundManager::disableOutput();
+    int sized = loadHeadlessTextureSizes();
+
+    GameState game(true);
+    if (seeded) RandomGenerator::seed(seed);
+    seed = RandomGenerator::getSeed();
+    HeadlessInput input(seed);
+    if (!scriptPath.empty() && !input.loadScript(scriptPath)) return 1;
+    if (!recordPath.empty() && !game.startRecording(recordPath)) return 1;
+    if (replaying) {
+        // The recording starts its own games
+        if (!game.startReplay(replayPath)) return 1;
+    }
+    else {
+        game.startGame();
+    }
+
+    bool checkAllocations = allocationWarmUp >= 0;
+    if (checkAllocations && !AllocationTracker::isBuiltIn()) {
+        cerr << "[FAIL] --alloc-check needs a debug build or -DSPACE_SHOOTER_TRACK_ALLOCATIONS" << endl;
+        return 1;
+    }
+    if (checkAllocations) AllocationTracker::start();
+    AllocationFrames allocationTicks(checkAllocations ? allocationWarmUp : 0);
+
+    EntityCounts peak;
+    int deaths = 0, victories = 0;
+    GameScreen lastScreen = game.getScreen();
+    long long ran = 0;
+    auto start = chrono::steady_clock::now();
+    for (; replaying ? game.isReplaying() : ran < ticks; ran++) {
+        if (!replaying) game.setInput(input.next());
+        game.stepSimulation();
+        if (checkAllocations) allocationTicks.endFrame();
+
+        EntityCounts counts = game.countEntities();
+        peak.enemies = max(peak.enemies, counts.enemies);
+        peak.bullets = max(peak.bullets, counts.bullets);
+        peak.powerUps = max(peak.powerUps, counts.powerUps);
+        peak.explosions = max(peak.explosions, counts.explosions);
+        peak.particles = max(peak.particles, counts.particles);
+
+        GameScreen screen = game.getScreen();
+        bool finished = screen == GameScreen::GameOver || screen == GameScreen::Victory;
+        if (finished && screen != lastScreen) (screen == GameScreen::Victory ? victories : deaths)++;
+
+        // Keep soaking: a finished game starts over straight away
+        if (finished && !replaying) game.startGame();
+        lastScreen = game.getScreen();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    AllocationTracker::stop();
+    game.stopRecording();
+    if (!profilePath.empty()) Profiler::writeTrace(profilePath);
+
+    EntityCounts now = game.countEntities();
+    if (replaying) {
+        cout << "  input replayed from " << replayPath;
+    }
+    else {
+        cout << "  seed " << seed << ", input " << (scriptPath.empty() ? "random" : scriptPath);
+    }
+    cout << ", texture sizes " << sized << "/" << TEXTURE_COUNT << endl;
+    cout << "  ticks: " << ran << " in " << seconds << " s = " << ran / seconds << " ticks/s ("
+        << ran / seconds / SIMULATION_TICK_RATE << "x real time)" << endl;
+    cout << "  games: " << deaths << " lost, " << victories << " won" << endl;
+    cout << "  entities at end:  enemies " << now.enemies << ", bullets " << now.bullets
+        << ", power-ups " << now.powerUps << ", explosions " << now.explosions << ", particles " << now.particles << endl;
+    cout << "  entities at peak: enemies " << peak.enemies << ", bullets " << peak.bullets
+        << ", power-ups " << peak.powerUps << ", explosions " << peak.explosions << ", particles " << peak.particles << endl;
+    cout << "  peak memory: " << peakMemoryBytes() / (1024.0 * 1024.0) << " MB" << endl;
+    if (checkAllocations) {
+        allocationTicks.printReport("tick");
+        if (allocationTicks.allocatedAfterWarmUp()) {
+            cerr << "[FAIL] Heap allocations after warm-up" << endl;
+            return 1;
+        }
+        cout << "[OK] No heap allocations after warm-up" << endl;
+    }
+    return game.getReplayMismatches() == 0 ? 0 : 1;
+}
+
+// ============================================================================
+// SCENARIO BENCHMARKS - Run with: SpaceShooter --scenarios [name] [--ticks N]
+//                                 [--json file] [--compare baseline.json]
+// ============================================================================
+//
+// Puts a headless GameState into a fixed heavy scene and times every tick by
+// subsystem. The player holds fire and sweeps side to side, and is kept alive
+// so every tick measures the same scene. Results go to the console and,
+// with --json, to a file that a later run can be compared against.
+
+struct Scenario {
+    const char* name;
+    const char* description;
+    void (*setup)(GameState& game);
+    void (*everyTick)(GameState& game, long long tick);   // keeps the scene going
+};
+
+const int SCENARIO_WARMUP_TICKS = 120;
+const int SCENARIO_DEFAULT_RUNS = 5;   // repeats of every scenario, interleaved
+
+// Subsystems as reported, in JSON order
+const char* const SCENARIO_METRICS[] = { "update", "collision", "removeInactive", "particles", "drawList", "tick" };
+const int SCENARIO_METRIC_COUNT = static_cast<int>(size(SCENARIO_METRICS));
+
+void keepPlayerAlive(GameState& game) {
+    Spaceship& player = game.getPlayer();
+    player.setHealth(player.getMaxHealth());
+}
+
+const Scenario SCENARIOS[] = {
+    { "dragon-wave", "level 2 phase 2 wave plus 6 Dragons, refilled when half are gone",
+        [](GameState& game) {
+            game.startScenario(1, 2, 2);
+            for (int i = 0; i < 6; i++) game.addEnemy(make_unique<DragonEnemy>(2, 2), Vector2(150.0f + i * 180.0f, -60.0f));
+        },
+        [](GameState& game, long long) {
+            keepPlayerAlive(game);
+            if (game.countEntities().enemies < 11) {
+                game.spawnEnemies();
+                for (int i = 0; i < 6; i++) game.addEnemy(make_unique<DragonEnemy>(2, 2), Vector2(150.0f + i * 180.0f, -60.0f));
+            }
+        } },
+    { "boss-phase-3", "final boss held at 25% health, player at maximum multishot",
+        [](GameState& game) {
+            game.startScenario(2, MAX_LEVELS + 1, 1);
+            for (int i = 0; i < 5; i++) {
+                game.getPlayer().applyPowerUp(PowerUpType::MultiShot);
+                game.getPlayer().applyPowerUp(PowerUpType::Power);
+            }
+        },
+        [](GameState& game, long long) {
+            keepPlayerAlive(game);
+            FinalBoss* boss = game.getBoss();
+            if (!boss) return;
+            boss->setHealth(boss->getMaxHealth() * 0.25f);
+            // The phase 3 path dips below the entry height, which would send
+            // the boss back into its descent; keep it on the fighting path
+            if (boss->getPosition().y < 150) boss->setPosition(Vector2(boss->getPosition().x, 150));
+        } },
+    { "nuke-30", "30 enemies on screen, cleared by a nuke pickup every second",
+        [](GameState& game) { game.startScenario(3, 2, 1); },
+        [](GameState& game, long long tick) {
+            keepPlayerAlive(game);
+            long long phase = (tick + SCENARIO_WARMUP_TICKS) % 120;
+            if (phase == 0) {
+                for (int i = 0; i < 30; i++) {
+                    Vector2 pos(80.0f + (i % 10) * 115.0f, 80.0f + (i / 10) * 90.0f);
+                    if (i % 3 == 0) game.addEnemy(make_unique<MonsterEnemy>(2, 1), pos);
+                    else game.addEnemy(make_unique<GammaEnemy>(2, 1), pos);
+                }
+            }
+            else if (phase == 30) {
+                game.addPowerUp(PowerUpType::Nuke, game.getPlayer().getPosition());
+            }
+        } },
+    { "particles-5000", "level 1 wave with 5000 particles kept alive",
+        [](GameState& game) {
+            game.startScenario(4, 1, 2);
+            game.setParticleCapacity(5000);
+        },
+        [](GameState& game, long long) {
+            keepPlayerAlive(game);
+            ParticleSystem& particles = game.getParticles();
+            int missing = 5000 - static_cast<int>(particles.getCount());
+            if (missing > 0) particles.emit(Vector2(SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2), Vector2(0, 0), sf::Color(255, 160, 60), missing, 2.0f);
+        } },
+};
+
+struct MetricSummary {
+    double mean = 0, p50 = 0, p99 = 0;   // microseconds per tick
+};
+
+struct ScenarioResult {
+    string name;
+    MetricSummary metrics[SCENARIO_METRIC_COUNT];   // median over the runs
+    MetricSummary best[SCENARIO_METRIC_COUNT];      // fastest run, per statistic
+    EntityCounts peak;
+};
+
+MetricSummary summarize(vector<double>& samples) {
+    MetricSummary summary;
+    if (samples.empty()) return summary;
+    sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double sample : samples) sum += sample;
+    auto percentile = [&samples](double q) { return samples[static_cast<size_t>(q * (samples.size() - 1) + 0.5)]; };
+    summary.mean = sum / samples.size();
+    summary.p50 = percentile(0.50);
+    summary.p99 = percentile(0.99);
+    return summary;
+}
+
+ScenarioResult runScenario(const Scenario& scenario, long long ticks) {
+    GameState game(true);
+    scenario.setup(game);
+    game.setTickTiming(true);
+
+    PlayerInput input;
+    input.fire = true;
+    vector<double> samples[SCENARIO_METRIC_COUNT];
+    for (auto& metric : samples) metric.reserve(static_cast<size_t>(ticks));
+
+    ScenarioResult result;
+    result.name = scenario.name;
+    for (long long t = -SCENARIO_WARMUP_TICKS; t < ticks; t++) {
+        scenario.everyTick(game, t);
+        bool sweepLeft = (t / 240) % 2 == 0;
+        input.left = sweepLeft;
+        input.right = !sweepLeft;
+        game.setInput(input);
+
+        auto start = chrono::steady_clock::now();
+        game.stepSimulation();
+        auto stepped = chrono::steady_clock::now();
+        game.publishSnapshot();
+        auto published = chrono::steady_clock::now();
+        if (t < 0) continue;
+
+        const TickTimings& timings = game.getTickTimings();
+        double values[SCENARIO_METRIC_COUNT] = {
+            timings.update(), timings.collision, timings.cleanup, timings.particles,
+            chrono::duration<double, milli>(published - stepped).count(),
+            chrono::duration<double, milli>(published - start).count()
+        };
+        for (int m = 0; m < SCENARIO_METRIC_COUNT; m++) samples[m].push_back(values[m] * 1000.0);
+
+        EntityCounts counts = game.countEntities();
+        result.peak.enemies = max(result.peak.enemies, counts.enemies);
+        result.peak.bullets = max(result.peak.bullets, counts.bullets);
+        result.peak.explosions = max(result.peak.explosions, counts.explosions);
+        result.peak.particles = max(result.peak.particles, counts.particles);
+    }
+    if (game.getScreen() != GameScreen::Gameplay) {
+        cerr << "[FAIL] Scenario " << scenario.name << " left gameplay for " << screenName(game.getScreen()) << endl;
+    }
+
+    for (int m = 0; m < SCENARIO_METRIC_COUNT; m++) result.metrics[m] = summarize(samples[m]);
+    return result;
+}
+
+// Folds repeated runs of one scenario into medians (what is reported and
+// saved) and per-statistic minimums (what a regression has to beat)
+ScenarioResult combineRuns(vector<ScenarioResult>& runs) {
+    ScenarioResult combined = runs[0];
+    vector<double> values(runs.size());
+    auto fold = [&](int m, double MetricSummary::* field) {
+        for (size_t r = 0; r < runs.size(); r++) values[r] = runs[r].metrics[m].*field;
+        sort(values.begin(), values.end());
+        combined.metrics[m].*field = values[values.size() / 2];
+        combined.best[m].*field = values[0];
+    };
+    for (int m = 0; m < SCENARIO_METRIC_COUNT; m++) {
+        fold(m, &MetricSummary::mean);
+        fold(m, &MetricSummary::p50);
+        fold(m, &MetricSummary::p99);
+    }
+    return combined;
+}
+
+bool writeScenarioJson(const string& path, const vector<ScenarioResult>& results, long long ticks) {
+    ofstream file(path);
+    if (!file.is_open()) {
+        cerr << "[FAIL] Could not write: " << path << endl;
+        return false;
+    }
+    // One metric per line, which is what readScenarioJson() expects
+    file << "{\n  \"unit\": \"us/tick\",\n  \"ticks\": " << ticks << ",\n  \"scenarios\": {\n";
+    for (size_t s = 0; s < results.size(); s++) {
+        file << "    \"" << results[s].name << "\": {\n";
+        for (int m = 0; m < SCENARIO_METRIC_COUNT; m++) {
+            const MetricSummary& metric = results[s].metrics[m];
+            file << "      \"" << SCENARIO_METRICS[m] << "\": { \"mean\": " << metric.mean
+                << ", \"p50\": " << metric.p50 << ", \"p99\": " << metric.p99 << " }"
+                << (m + 1 < SCENARIO_METRIC_COUNT ? "," : "") << "\n";
+        }
+        file << "    }" << (s + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  }\n}\n";
+    cout << "[OK] Wrote " << path << endl;
+    return true;
+}
+
+// Reads back a file written by writeScenarioJson(); keyed "scenario/metric"
+bool readScenarioJson(const string& path, map<string, MetricSummary>& baseline) {
+    ifstream file(path);
+    if (!file.is_open()) {
+        cerr << "[FAIL] Could not read baseline: " << path << endl;
+        return false;
+    }
+    string line, scenario;
+    while (getline(file, line)) {
+        size_t open = line.find('"');
+        size_t close = open == string::npos ? string::npos : line.find('"', open + 1);
+        if (close == string::npos) continue;
+        string key = line.substr(open + 1, close - open - 1);
+
+        MetricSummary metric;
+        if (sscanf(line.c_str() + close + 1, ": { \"mean\": %lf, \"p50\": %lf, \"p99\": %lf", &metric.mean, &metric.p50, &metric.p99) == 3) {
+            baseline[scenario + "/" + key] = metric;
+        }
+        else if (line.find('{') != string::npos && key != "scenarios") {
+            scenario = key;
+        }
+    }
+    return !baseline.empty();
+}
+
+// A metric regresses when its mean or p99 grows by more than thresholdPercent
+// in every run: the fastest run is compared with the baseline's median, so one
+// slow stretch of a busy machine can't fail the check on its own. Differences
+// under a microsecond are timer noise and never count.
+int compareScenarioResults(const vector<ScenarioResult>& results, const map<string, MetricSummary>& baseline,
+    double thresholdPercent) {
+    const double noiseFloorUs = 1.0;
+    int regressions = 0;
+    cout << "\n=== Compared with baseline (threshold " << thresholdPercent << "%) ===" << endl;
+    for (const ScenarioResult& result : results) {
+        for (int m = 0; m < SCENARIO_METRIC_COUNT; m++) {
+            auto found = baseline.find(result.name + "/" + SCENARIO_METRICS[m]);
+            if (found == baseline.end()) continue;
+            const MetricSummary& before = found->second;
+            const MetricSummary& now = result.metrics[m];
+            auto regressed = [&](double was, double is) {
+                return is - was > noiseFloorUs && is > was * (1.0 + thresholdPercent / 100.0);
+            };
+            const MetricSummary& best = result.best[m];
+            bool worse = regressed(before.mean, best.mean) || regressed(before.p99, best.p99);
+            double change = before.mean > 0 ? (now.mean / before.mean - 1.0) * 100.0 : 0.0;
+            cout << (worse ? "  [REGRESSION] " : "  ") << result.name << " " << SCENARIO_METRICS[m]
+                << ": mean " << before.mean << " -> " << now.mean << " us (" << (change >= 0 ? "+" : "") << change
+                << "%), p99 " << before.p99 << " -> " << now.p99 << " us" << endl;
+            if (worse) regressions++;
+        }
+    }
+    cout << "  " << regressions << " regression(s)" << endl;
+    return regressions;
+}
+
+int runScenarios(int argc, char* argv[]) {
+    string name = "all", jsonPath, baselinePath;
+    long long ticks = 2400;   // 20 s of game time at 120 Hz
+    int runs = SCENARIO_DEFAULT_RUNS;
+    double thresholdPercent = 10.0;
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--ticks" && i + 1 < argc) ticks = max(1LL, atoll(argv[++i]));
+        else if (arg == "--runs" && i + 1 < argc) runs = max(1, atoi(argv[++i]));
+        else if (arg == "--json" && i + 1 < argc) jsonPath = argv[++i];
+        else if (arg == "--compare" && i + 1 < argc) baselinePath = argv[++i];
+        else if (arg == "--threshold" && i + 1 < argc) thresholdPercent = atof(argv[++i]);
+        else name = arg;
+    }
+
+    map<string, MetricSummary> baseline;
+    if (!baselinePath.empty() && !readScenarioJson(baselinePath, baseline)) return 1;
+
+    cout << "\n=== Scenario Benchmarks (" << ticks << " ticks each, median of " << runs << " runs, us/tick) ===" << endl;
+    SoundManager::disableOutput();
+    loadHeadlessTextureSizes();
+
+    // Runs go round all the selected scenarios in turn, so a slow patch on the
+    // machine is spread over every scenario instead of landing on one
+    vector<const Scenario*> selected;
+    for (const Scenario& scenario : SCENARIOS) {
+        if (name == "all" || name == scenario.name) selected.push_back(&scenario);
+    }
+    vector<vector<ScenarioResult>> runResults(selected.size());
+    for (int run = 0; run < runs; run++) {
+        for (size_t s = 0; s < selected.size(); s++) runResults[s].push_back(runScenario(*selected[s], ticks));
+    }
+
+    vector<ScenarioResult> results;
+    for (size_t s = 0; s < selected.size(); s++) {
+        const Scenario& scenario = *selected[s];
+        results.push_back(combineRuns(runResults[s]));
+
+        const ScenarioResult& result = results.back();
+        cout << "\n  " << scenario.name << ": " << scenario.description << endl;
+        cout << "    peak: enemies " << result.peak.enemies << ", bullets " << result.peak.bullets
+            << ", explosions " << result.peak.explosions << ", particles " << result.peak.particles << endl;
+        for (int m = 0; m < SCENARIO_METRIC_COUNT; m++) {
+            const MetricSummary& metric = result.metrics[m];
+            cout << "    " << SCENARIO_METRICS[m] << ": mean " << metric.mean << "  p50 " << metric.p50
+                << "  p99 " << metric.p99 << endl;
+        }
+    }
+    if (results.empty()) {
+        cerr << "Unknown scenario: " << name << endl;
+        return 1;
+    }
+
+    if (!jsonPath.empty() && !writeScenarioJson(jsonPath, results, ticks)) return 1;
+    if (!baseline.empty() && compareScenarioResults(results, baseline, thresholdPercent) > 0) return 1;
+    return 0;
+}
+
 // ============================================================================
 // MAIN FUNCTION
 // ============================================================================
 
-int main() {
+// Define SPACE_SHOOTER_NO_MAIN to build everything above into another program
+// (a test or benchmark driver) that brings its own main()
+#ifndef SPACE_SHOOTER_NO_MAIN
+int main(int argc, char* argv[]) {
+    if (argc > 2 && string(argv[1]) == "--bench" && string(argv[2]) == "micro") {
+        // --bench micro [kernel] [--items N]
+        string filter = "all";
+        size_t items = 0;
+        for (int i = 3; i < argc; i++) {
+            if (string(argv[i]) == "--items" && i + 1 < argc) items = strtoull(argv[++i], nullptr, 10);
+            else filter = argv[i];
+        }
+        return runMicrobenchmarks(filter, items);
+    }
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        return runBenchmarks(argc > 2 ? argv[2] : "all");
+    }
+    if (argc > 1 && string(argv[1]) == "--headless") {
+        return runHeadless(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--scenarios") {
+        return runScenarios(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--pack-assets") {
+        return packAssetBundle(argc > 2 ? argv[2] : ASSET_BUNDLE_PATH) ? 0 : 1;
+    }
+
     cout << "========================================" << endl;
     cout << "  SPACE SHOOTER ULTIMATE EDITION v5.0  " << endl;
     cout << "========================================" << endl;
     cout << "Starting game..." << endl;
 
+    float tickRate = SIMULATION_TICK_RATE;
+    bool threadedSimulation = true;
+    string recordPath, replayPath, profilePath;
+    bool trackAllocations = false;
+    for (int i = 1; i < argc; i++) {
+        // Old blocking music switches, to compare the [PERF] transition lines against
+        if (string(argv[i]) == "--sync-music") SoundManager::getInstance().setAsyncMusic(false);
+        if (string(argv[i]) == "--tick-rate" && i + 1 < argc) tickRate = static_cast<float>(atof(argv[++i]));
+        if (string(argv[i]) == "--single-thread") threadedSimulation = false;
+        if (string(argv[i]) == "--record" && i + 1 < argc) recordPath = argv[++i];
+        if (string(argv[i]) == "--replay" && i + 1 < argc) replayPath = argv[++i];
+        if (string(argv[i]) == "--profile") {
+            profilePath = i + 1 < argc && argv[i + 1][0] != '-' ? argv[++i] : PROFILE_DEFAULT_PATH;
+        }
+        if (string(argv[i]) == "--track-allocations") trackAllocations = true;
+    }
+    if (trackAllocations && !AllocationTracker::isBuiltIn()) {
+        cerr << "[FAIL] --track-allocations needs a debug build or -DSPACE_SHOOTER_TRACK_ALLOCATIONS" << endl;
+        trackAllocations = false;
+    }
+    // From the first frame, so the loading screen is in the trace too
+    Profiler::setThreadName("main");
+    if (!profilePath.empty()) Profiler::start();
+
     sf::RenderWindow window(sf::VideoMode(static_cast<unsigned int>(SCREEN_WIDTH),
         static_cast<unsigned int>(SCREEN_HEIGHT)),
         GAME_TITLE);
@@ -2636,21 +8097,50 @@ int main() {
     cout << "Window created: " << SCREEN_WIDTH << "x" << SCREEN_HEIGHT << endl;
 
     GameState game;
+    game.setTickRate(tickRate);
+    if (!profilePath.empty()) game.setProfilePath(profilePath);
+    if (!replayPath.empty()) game.startReplay(replayPath);
+    else if (!recordPath.empty()) game.startRecording(recordPath);
+    if (threadedSimulation) game.startSimulationThread();
 
     cout << "Game initialized. Starting main loop..." << endl;
     cout << "========================================" << endl;
 
+    if (trackAllocations) AllocationTracker::start();
+    AllocationFrames allocationFrames;
+
+    sf::Clock runClock;
     while (window.isOpen()) {
-        sf::Event event;
-        while (window.pollEvent(event)) {
-            game.handleEvent(event, window);
+        {
+            auto lock = game.lockState();
+            game.pollInput(window);
+            game.update();
         }
-
-        game.handleContinuousInput();
-        game.update();
+        game.writePendingTrace();
         game.draw(window);
+        if (trackAllocations) allocationFrames.endFrame();
     }
-
+    game.stopSimulationThread();
+    AllocationTracker::stop();
+    game.stopRecording();
+    if (Profiler::isEnabled()) Profiler::writeTrace(profilePath.empty() ? PROFILE_DEFAULT_PATH : profilePath);
+
+    float runSeconds = runClock.getElapsedTime().asSeconds();
+    cout << "[PERF] " << (threadedSimulation ? "Threaded" : "Single-threaded") << ": "
+        << game.getSimulationTicks() / runSeconds << " ticks/s, "
+        << game.getFramesDrawn() / runSeconds << " frames/s, "
+        << game.getSnapshotBuffer().getPublishCount() << " snapshots published, "
+        << game.getSnapshotBuffer().getFreshReadCount() << " drawn" << endl;
+    game.printScreenDrawTimes();
+
+    cout << "Bullet pool high-water mark: " << game.getBulletPool().getHighWaterMark()
+        << "/" << game.getBulletPool().getCapacity() << endl;
+    SoundManager& sm = SoundManager::getInstance();
+    cout << "Sound voices: peak " << sm.getPeakActiveVoices() << "/" << sm.getVoiceCapacity()
+        << ", stolen " << sm.getStolenVoiceCount() << ", dropped " << sm.getDroppedSoundCount()
+        << ", coalesced " << sm.getCoalescedSoundCount() << endl;
+    if (trackAllocations) allocationFrames.printReport("frame");
     cout << "Game closed. Thank you for playing!" << endl;
     return 0;
 }
+#endif // SPACE_SHOOTER_NO_MAIN